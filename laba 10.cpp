@@ -1,450 +1,5518 @@
-#include <iostream>
-#include <string>
-#include <vector>
-#include <memory>
-#include <fstream>
-#include <algorithm>
-#include <exception>
-#include <locale.h>
-
-// Base User class with encapsulation
-class User {
-private:
-    std::string name;
-    int id;
-    int accessLevel;
-
-public:
-    User(const std::string& name, int id, int accessLevel) {
-        setName(name);
-        setId(id);
-        setAccessLevel(accessLevel);
-    }
-
-    virtual ~User() = default;
-
-    // Getters
-    std::string getName() const { return name; }
-    int getId() const { return id; }
-    int getAccessLevel() const { return accessLevel; }
-
-    // Setters with validation
-    void setName(const std::string& newName) {
-        if (newName.empty()) {
-            throw std::invalid_argument("Имя не может быть пустым");
-        }
-        name = newName;
-    }
-
-    void setId(int newId) {
-        if (newId < 0) {
-            throw std::invalid_argument("ID не может быть отрицательным");
-        }
-        id = newId;
-    }
-
-    void setAccessLevel(int newAccessLevel) {
-        if (newAccessLevel < 0) {
-            throw std::invalid_argument("Уровень доступа не может быть отрицательным");
-        }
-        accessLevel = newAccessLevel;
-    }
-
-    // Virtual method for polymorphism
-    virtual void displayInfo() const {
-        std::cout << "Пользователь: " << name << ", ID: " << id << ", Уровень доступа: " << accessLevel << std::endl;
-    }
-};
-
-// Derived Student class
-class Student : public User {
-private:
-    std::string group;
-
-public:
-    Student(const std::string& name, int id, int accessLevel, const std::string& group)
-        : User(name, id, accessLevel), group(group) {}
-
-    void setGroup(const std::string& newGroup) {
-        if (newGroup.empty()) {
-            throw std::invalid_argument("Группа не может быть пустой");
-        }
-        group = newGroup;
-    }
-
-    std::string getGroup() const { return group; }
-
-    void displayInfo() const override {
-        std::cout << "Студент: " << getName() << ", ID: " << getId()
-                  << ", Уровень доступа: " << getAccessLevel() << ", Группа: " << group << std::endl;
-    }
-};
-
-// Derived Teacher class
-class Teacher : public User {
-private:
-    std::string department;
-
-public:
-    Teacher(const std::string& name, int id, int accessLevel, const std::string& department)
-        : User(name, id, accessLevel), department(department) {}
-
-    void setDepartment(const std::string& newDepartment) {
-        if (newDepartment.empty()) {
-            throw std::invalid_argument("Кафедра не может быть пустой");
-        }
-        department = newDepartment;
-    }
-
-    std::string getDepartment() const { return department; }
-
-    void displayInfo() const override {
-        std::cout << "Преподаватель: " << getName() << ", ID: " << getId()
-                  << ", Уровень доступа: " << getAccessLevel() << ", Кафедра: " << department << std::endl;
-    }
-};
-
-// Derived Administrator class
-class Administrator : public User {
-private:
-    int adminLevel;
-
-public:
-    Administrator(const std::string& name, int id, int accessLevel, int adminLevel)
-        : User(name, id, accessLevel), adminLevel(adminLevel) {
-        if (adminLevel < 0) {
-            throw std::invalid_argument("Уровень администратора не может быть отрицательным");
-        }
-    }
-
-    void setAdminLevel(int newAdminLevel) {
-        if (newAdminLevel < 0) {
-            throw std::invalid_argument("Уровень администратора не может быть отрицательным");
-        }
-        adminLevel = newAdminLevel;
-    }
-
-    int getAdminLevel() const { return adminLevel; }
-
-    void displayInfo() const override {
-        std::cout << "Администратор: " << getName() << ", ID: " << getId()
-                  << ", Уровень доступа: " << getAccessLevel() << ", Уровень администратора: " << adminLevel << std::endl;
-    }
-};
-
-// Resource class representing university resources
-class Resource {
-private:
-    std::string resourceName;
-    int requiredAccessLevel;
-
-public:
-    Resource(const std::string& name, int accessLevel)
-        : resourceName(name), requiredAccessLevel(accessLevel) {
-        if (name.empty()) {
-            throw std::invalid_argument("Имя ресурса не может быть пустым");
-        }
-        if (accessLevel < 0) {
-            throw std::invalid_argument("Уровень доступа не может быть отрицательным");
-        }
-    }
-
-    std::string getName() const { return resourceName; }
-    int getRequiredAccessLevel() const { return requiredAccessLevel; }
-
-    bool checkAccess(const User& user) const {
-        return user.getAccessLevel() >= requiredAccessLevel;
-    }
-
-    void displayInfo() const {
-        std::cout << "Ресурс: " << resourceName << ", Требуемый уровень доступа: " << requiredAccessLevel << std::endl;
-    }
-};
-
-// Template class AccessControlSystem to manage users and resources
-template <typename UserType, typename ResourceType>
-class AccessControlSystem {
-private:
-    std::vector<std::shared_ptr<UserType>> users;
-    std::vector<std::shared_ptr<ResourceType>> resources;
-
-public:
-    void addUser(std::shared_ptr<UserType> user) {
-        users.push_back(user);
-    }
-
-    void addResource(std::shared_ptr<ResourceType> resource) {
-        resources.push_back(resource);
-    }
-
-    void displayUsers() const {
-        for (const auto& user : users) {
-            user->displayInfo();
-        }
-    }
-
-    void displayResources() const {
-        for (const auto& resource : resources) {
-            resource->displayInfo();
-        }
-    }
-
-    bool checkUserAccessToResource(int userId, const std::string& resourceName) const {
-        auto userIt = std::find_if(users.begin(), users.end(),
-            [userId](const std::shared_ptr<UserType>& user) { return user->getId() == userId; });
-        if (userIt == users.end()) {
-            throw std::runtime_error("Пользователь не найден");
-        }
-
-        auto resourceIt = std::find_if(resources.begin(), resources.end(),
-            [&resourceName](const std::shared_ptr<ResourceType>& resource) { return resource->getName() == resourceName; });
-        if (resourceIt == resources.end()) {
-            throw std::runtime_error("Ресурс не найден");
-        }
-
-        return (*resourceIt)->checkAccess(**userIt);
-    }
-
-    // Search users by name
-    std::vector<std::shared_ptr<UserType>> searchUsersByName(const std::string& name) const {
-        std::vector<std::shared_ptr<UserType>> result;
-        for (const auto& user : users) {
-            if (user->getName() == name) {
-                result.push_back(user);
-            }
-        }
-        return result;
-    }
-
-    // Search users by ID
-    std::shared_ptr<UserType> searchUserById(int id) const {
-        auto it = std::find_if(users.begin(), users.end(),
-            [id](const std::shared_ptr<UserType>& user) { return user->getId() == id; });
-        if (it != users.end()) {
-            return *it;
-        }
-        return nullptr;
-    }
-
-    // Sort users by access level ascending
-    void sortUsersByAccessLevel() {
-        std::sort(users.begin(), users.end(),
-            [](const std::shared_ptr<UserType>& a, const std::shared_ptr<UserType>& b) {
-                return a->getAccessLevel() < b->getAccessLevel();
-            });
-    }
-
-    // Save users and resources to files
-    void saveToFile(const std::string& usersFile, const std::string& resourcesFile) const {
-        std::ofstream uFile(usersFile);
-        if (!uFile) {
-            throw std::runtime_error("Не удалось открыть файл пользователей для записи");
-        }
-        for (const auto& user : users) {
-            // Save user type info for loading
-            if (dynamic_cast<Student*>(user.get())) {
-                uFile << "Student ";
-                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << " ";
-                uFile << static_cast<Student*>(user.get())->getGroup() << std::endl;
-            } else if (dynamic_cast<Teacher*>(user.get())) {
-                uFile << "Teacher ";
-                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << " ";
-                uFile << static_cast<Teacher*>(user.get())->getDepartment() << std::endl;
-            } else if (dynamic_cast<Administrator*>(user.get())) {
-                uFile << "Administrator ";
-                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << " ";
-                uFile << static_cast<Administrator*>(user.get())->getAdminLevel() << std::endl;
-            } else {
-                uFile << "User ";
-                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << std::endl;
-            }
-        }
-        uFile.close();
-
-        std::ofstream rFile(resourcesFile);
-        if (!rFile) {
-            throw std::runtime_error("Не удалось открыть файл ресурсов для записи");
-        }
-        for (const auto& resource : resources) {
-            rFile << resource->getName() << " " << resource->getRequiredAccessLevel() << std::endl;
-        }
-        rFile.close();
-    }
-
-    // Load users and resources from files
-    void loadFromFile(const std::string& usersFile, const std::string& resourcesFile) {
-        users.clear();
-        resources.clear();
-
-        std::ifstream uFile(usersFile);
-        if (!uFile) {
-            throw std::runtime_error("Не удалось открыть файл пользователей для чтения");
-        }
-        std::string userType;
-        while (uFile >> userType) {
-            if (userType == "Student") {
-                std::string name, group;
-                int id, accessLevel;
-                uFile >> name >> id >> accessLevel >> group;
-                addUser(std::make_shared<Student>(name, id, accessLevel, group));
-            } else if (userType == "Teacher") {
-                std::string name, department;
-                int id, accessLevel;
-                uFile >> name >> id >> accessLevel >> department;
-                addUser(std::make_shared<Teacher>(name, id, accessLevel, department));
-            } else if (userType == "Administrator") {
-                std::string name;
-                int id, accessLevel, adminLevel;
-                uFile >> name >> id >> accessLevel >> adminLevel;
-                addUser(std::make_shared<Administrator>(name, id, accessLevel, adminLevel));
-            } else if (userType == "User") {
-                std::string name;
-                int id, accessLevel;
-                uFile >> name >> id >> accessLevel;
-                addUser(std::make_shared<User>(name, id, accessLevel));
-            } else {
-                // Unknown user type, skip line
-                std::string skipLine;
-                std::getline(uFile, skipLine);
-            }
-        }
-        uFile.close();
-
-        std::ifstream rFile(resourcesFile);
-        if (!rFile) {
-            throw std::runtime_error("Не удалось открыть файл ресурсов для чтения");
-        }
-        std::string resourceName;
-        int accessLevel;
-        while (rFile >> resourceName >> accessLevel) {
-            addResource(std::make_shared<Resource>(resourceName, accessLevel));
-        }
-        rFile.close();
-    }
-};
-
-int main() {
-    setlocale (LC_ALL, "Russian");
-    try {
-        AccessControlSystem<User, Resource> system;
-
-        // Add users
-        system.addUser(std::make_shared<Student>("Андрей Андреев", 1, 2, "Т.РИ23"));
-        system.addUser(std::make_shared<Student>("Максим Минимумов", 2, 2, "Т.РИ22"));
-        system.addUser(std::make_shared<Teacher>("Подколзина Любовь Александровна", 3, 3, "Т-Университет"));
-        system.addUser(std::make_shared<Administrator>("Михалёва Алина Викторовна", 4, 5, 1));
-
-        // Add resources
-        system.addResource(std::make_shared<Resource>("Библиотека ДГТУ", 1));
-        system.addResource(std::make_shared<Resource>("Материалы лаборатории", 3));
-        system.addResource(std::make_shared<Resource>("Панель администратора", 5));
-
-        bool running = true;
-        while (running) {
-            std::cout << "\nВыберите действие:\n";
-            std::cout << "1. Показать пользователей\n";
-            std::cout << "2. Показать ресурсы\n";
-            std::cout << "3. Проверить доступ пользователя к ресурсу\n";
-            std::cout << "4. Поиск пользователей по имени\n";
-            std::cout << "5. Сортировать пользователей по уровню доступа\n";
-            std::cout << "6. Сохранить данные в файлы\n";
-            std::cout << "7. Загрузить данные из файлов\n";
-            std::cout << "8. Выход\n";
-            std::cout << "Введите выбор: ";
-
-            int choice;
-            std::cin >> choice;
-
-            switch (choice) {
-                case 1: {
-                    system.displayUsers();
-                    break;
-                }
-                case 2: {
-                    system.displayResources();
-                    break;
-                }
-                case 3: {
-                    std::cout << "Введите ID пользователя: ";
-                    int userId;
-                    std::cin >> userId;
-                    std::cout << "Введите имя ресурса: ";
-                    std::string resourceName;
-                    std::cin.ignore();
-                    std::getline(std::cin, resourceName);
-                    try {
-                        bool hasAccess = system.checkUserAccessToResource(userId, resourceName);
-                        std::cout << "Пользователь с ID " << userId << (hasAccess ? " имеет " : " не имеет ") << "доступ к " << resourceName << std::endl;
-                    } catch (const std::exception& e) {
-                        std::cout << "Ошибка: " << e.what() << std::endl;
-                    }
-                    break;
-                }
-                case 4: {
-                    std::cout << "Введите имя для поиска: ";
-                    std::string searchName;
-                    std::cin.ignore();
-                    std::getline(std::cin, searchName);
-                    auto foundUsers = system.searchUsersByName(searchName);
-                    std::cout << "Результаты поиска пользователей с именем \"" << searchName << "\":" << std::endl;
-                    for (const auto& user : foundUsers) {
-                        user->displayInfo();
-                    }
-                    break;
-                }
-                case 5: {
-                    system.sortUsersByAccessLevel();
-                    std::cout << "Пользователи отсортированы по уровню доступа:" << std::endl;
-                    system.displayUsers();
-                    break;
-                }
-                case 6: {
-                    std::cout << "Введите имя файла для данных пользователей: ";
-                    std::string usersFile;
-                    std::cin >> usersFile;
-                    std::cout << "Введите имя файла для данных ресурсов: ";
-                    std::string resourcesFile;
-                    std::cin >> resourcesFile;
-                    try {
-                        system.saveToFile(usersFile, resourcesFile);
-                        std::cout << "Данные сохранены в файлы." << std::endl;
-                    } catch (const std::exception& e) {
-                        std::cout << "Ошибка при сохранении данных: " << e.what() << std::endl;
-                    }
-                    break;
-                }
-                case 7: {
-                    std::cout << "Введите имя файла для данных пользователей: ";
-                    std::string usersFile;
-                    std::cin >> usersFile;
-                    std::cout << "Введите имя файла для данных ресурсов: ";
-                    std::string resourcesFile;
-                    std::cin >> resourcesFile;
-                    try {
-                        system.loadFromFile(usersFile, resourcesFile);
-                        std::cout << "Данные загружены из файлов:" << std::endl;
-                        system.displayUsers();
-                        system.displayResources();
-                    } catch (const std::exception& e) {
-                        std::cout << "Ошибка при загрузке данных: " << e.what() << std::endl;
-                    }
-                    break;
-                }
-                case 8: {
-                    running = false;
-                    std::cout << "Выход из системы. До свидания!" << std::endl;
-                    break;
-                }
-                default: {
-                    std::cout << "Неверный выбор. Пожалуйста, попробуйте снова." << std::endl;
-                    break;
-                }
-            }
-        }
-
-    } catch (const std::exception& e) {
-        std::cerr << "Исключение: " << e.what() << std::endl;
-    }
-
-    return 0;
-}
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <fstream>
+#include <algorithm>
+#include <exception>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <random>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <iterator>
+#include <charconv>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <functional>
+#include <filesystem>
+#include <string_view>
+#include <array>
+#include <csignal>
+#include <cerrno>
+#include <locale.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+// Interned string: equal strings share one 32-bit ID, so they are stored
+// once and compared as integers. The default symbol is the empty string.
+struct Symbol {
+    uint32_t id = 0;
+
+    bool operator==(Symbol other) const { return id == other.id; }
+    bool operator!=(Symbol other) const { return id != other.id; }
+
+    const std::string& str() const;
+};
+
+// Process-wide table of interned strings. Symbols are never removed, so it
+// is meant for values with few distinct instances (groups, departments,
+// resource names). intern() and find() lock one of 16 shards chosen by the
+// hash; str() does not lock, since a symbol's string never moves or changes.
+class SymbolTable {
+private:
+    static const uint32_t SHARD_BITS = 4;
+    static const uint32_t SHARD_COUNT = 1u << SHARD_BITS;
+    static const uint32_t CHUNK_BITS = 10;
+    static const uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+    static const uint32_t MAX_CHUNKS = 1024;
+
+    // A symbol ID is (index in shard << SHARD_BITS) | shard
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string_view, uint32_t> ids;  // views into chunks
+        uint32_t count = 0;
+        std::atomic<std::string*> chunks[MAX_CHUNKS];
+    };
+
+    Shard shards[SHARD_COUNT];
+
+    SymbolTable() {
+        for (Shard& shard : shards) {
+            for (auto& chunk : shard.chunks) {
+                chunk.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+        // Index 0 of shard 0 is the empty string, the default Symbol
+        shards[0].chunks[0].store(new std::string[CHUNK_SIZE], std::memory_order_release);
+        shards[0].count = 1;
+    }
+
+    ~SymbolTable() {
+        for (Shard& shard : shards) {
+            for (auto& chunk : shard.chunks) {
+                delete[] chunk.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+public:
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    static SymbolTable& global() {
+        static SymbolTable table;
+        return table;
+    }
+
+    // A symbol split into its shard and its dense index within the shard,
+    // for tables indexed by symbol
+    static const uint32_t SHARDS = SHARD_COUNT;
+    static uint32_t shardOf(Symbol symbol) { return symbol.id & (SHARD_COUNT - 1); }
+    static uint32_t indexInShard(Symbol symbol) { return symbol.id >> SHARD_BITS; }
+
+    Symbol intern(std::string_view str) {
+        if (str.empty()) {
+            return Symbol();
+        }
+        const uint32_t shardIndex = static_cast<uint32_t>(std::hash<std::string_view>()(str)) & (SHARD_COUNT - 1);
+        Shard& shard = shards[shardIndex];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.ids.find(str);
+        if (it != shard.ids.end()) {
+            return Symbol{it->second};
+        }
+        const uint32_t index = shard.count;
+        if ((index >> CHUNK_BITS) >= MAX_CHUNKS) {
+            throw std::runtime_error("Таблица символов переполнена");
+        }
+        std::string* chunk = shard.chunks[index >> CHUNK_BITS].load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = new std::string[CHUNK_SIZE];
+            shard.chunks[index >> CHUNK_BITS].store(chunk, std::memory_order_release);
+        }
+        std::string& stored = chunk[index & (CHUNK_SIZE - 1)];
+        stored.assign(str.data(), str.size());
+        ++shard.count;
+        const uint32_t id = (index << SHARD_BITS) | shardIndex;
+        shard.ids.emplace(std::string_view(stored), id);
+        return Symbol{id};
+    }
+
+    // Symbol of an already interned string; does not add new strings
+    bool find(std::string_view str, Symbol& symbol) const {
+        if (str.empty()) {
+            symbol = Symbol();
+            return true;
+        }
+        const Shard& shard = shards[static_cast<uint32_t>(std::hash<std::string_view>()(str)) & (SHARD_COUNT - 1)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.ids.find(str);
+        if (it == shard.ids.end()) {
+            return false;
+        }
+        symbol = Symbol{it->second};
+        return true;
+    }
+
+    const std::string& str(Symbol symbol) const {
+        const Shard& shard = shards[symbol.id & (SHARD_COUNT - 1)];
+        const uint32_t index = symbol.id >> SHARD_BITS;
+        return shard.chunks[index >> CHUNK_BITS].load(std::memory_order_acquire)[index & (CHUNK_SIZE - 1)];
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total += shard.count;
+        }
+        return total;
+    }
+
+    // Approximate bytes of the strings, their hash index and the chunk tables
+    size_t memoryUsage() const {
+        size_t total = sizeof(SymbolTable);
+        for (const Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (uint32_t chunk = 0; chunk * CHUNK_SIZE < shard.count; ++chunk) {
+                total += CHUNK_SIZE * sizeof(std::string);
+            }
+            for (const auto& entry : shard.ids) {
+                total += entry.first.size() > 15 ? (entry.first.size() + 1 + sizeof(size_t) + 15) / 16 * 16 : 0;
+            }
+            total += shard.ids.bucket_count() * sizeof(void*) +
+                     shard.ids.size() * (sizeof(std::string_view) + sizeof(uint32_t) + 2 * sizeof(void*));
+        }
+        return total;
+    }
+};
+
+inline const std::string& Symbol::str() const {
+    return SymbolTable::global().str(*this);
+}
+
+// Interned strings stored back to back in large blocks that are never freed
+// or moved until the arena is destroyed, so the views it returns stay valid.
+// Unlike the SymbolTable it is owned, so its strings go away with it; it is
+// meant for many distinct values, such as the user names of a UserArena.
+// A string is stored with a 32-bit length prefix, and the index is an
+// open-addressing table of pointers to the stored strings, which costs far
+// less per string than a node-based hash set. intern() locks; reading a
+// returned view does not.
+class StringArena {
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t blockUsed = BLOCK_SIZE;
+    size_t bytesAllocated = 0;
+    std::vector<const char*> table;  // size is a power of two, nullptr = free
+    size_t count = 0;
+
+    static std::string_view viewOf(const char* stored) {
+        uint32_t length;
+        std::memcpy(&length, stored, sizeof(length));
+        return std::string_view(stored + sizeof(length), length);
+    }
+
+    static size_t hashOf(std::string_view str) {
+        return std::hash<std::string_view>()(str);
+    }
+
+    const char* store(std::string_view str) {
+        const size_t size = sizeof(uint32_t) + str.size();
+        char* dest;
+        if (size > BLOCK_SIZE / 4) {
+            // Large strings get a block of their own, kept before the current block
+            std::unique_ptr<char[]> block(new char[size]);
+            dest = block.get();
+            blocks.insert(blocks.empty() ? blocks.end() : blocks.end() - 1, std::move(block));
+            bytesAllocated += size;
+        } else {
+            if (BLOCK_SIZE - blockUsed < size) {
+                blocks.emplace_back(new char[BLOCK_SIZE]);
+                blockUsed = 0;
+                bytesAllocated += BLOCK_SIZE;
+            }
+            dest = blocks.back().get() + blockUsed;
+            blockUsed += size;
+        }
+        const uint32_t length = static_cast<uint32_t>(str.size());
+        std::memcpy(dest, &length, sizeof(length));
+        std::memcpy(dest + sizeof(length), str.data(), str.size());
+        return dest;
+    }
+
+    // Keeps the load factor at most 3/4
+    void grow() {
+        std::vector<const char*> next(std::max<size_t>(1024, table.size() * 2), nullptr);
+        const size_t mask = next.size() - 1;
+        for (const char* stored : table) {
+            if (stored) {
+                size_t i = hashOf(viewOf(stored)) & mask;
+                while (next[i]) {
+                    i = (i + 1) & mask;
+                }
+                next[i] = stored;
+            }
+        }
+        table.swap(next);
+    }
+
+public:
+    StringArena() = default;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    std::string_view intern(std::string_view str) {
+        if (str.size() > UINT32_MAX) {
+            throw std::length_error("Строка слишком длинная для арены строк");
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if ((count + 1) * 4 > table.size() * 3) {
+            grow();
+        }
+        const size_t mask = table.size() - 1;
+        for (size_t i = hashOf(str) & mask;; i = (i + 1) & mask) {
+            if (!table[i]) {
+                table[i] = store(str);
+                ++count;
+                return viewOf(table[i]);
+            }
+            std::string_view stored = viewOf(table[i]);
+            if (stored == str) {
+                return stored;
+            }
+        }
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return count;
+    }
+
+    // Approximate bytes held: blocks, the block table and the index
+    size_t memoryUsage() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return bytesAllocated + blocks.capacity() * sizeof(std::unique_ptr<char[]>) +
+               table.capacity() * sizeof(const char*);
+    }
+};
+
+class User;
+
+// Concrete user type, used where the type must be stored without dynamic_cast
+enum class UserKind : uint8_t {
+    User = 0,
+    Student = 1,
+    Teacher = 2,
+    Administrator = 3
+};
+
+// Kind of a rule of an AccessPolicy, as stored in journals and snapshots
+enum class PolicyRuleKind : uint8_t {
+    GroupGrant = 1,
+    DepartmentGrant = 2,
+    AdminOverride = 3
+};
+
+// Interface for objects that track changes of a user's access level, name
+// and the attributes access policies depend on (group, department, admin level)
+class UserObserver {
+public:
+    virtual ~UserObserver() = default;
+    virtual void onAccessLevelChanged(const User& user, int oldAccessLevel) = 0;
+    virtual void onNameChanged(const User& user, const std::string& oldName) = 0;
+    virtual void onAttributesChanged(const User& user) = 0;
+};
+
+// Base User class with encapsulation
+class User {
+private:
+    // The name is a string of nameArena for users of a UserArena, otherwise
+    // the heap buffer ownedName
+    std::unique_ptr<char[]> ownedName;
+    std::string_view name;
+    StringArena* nameArena = nullptr;
+    int id;
+    int accessLevel;
+    UserObserver* observer = nullptr;
+
+    friend class UserArena;
+
+    void storeName(std::string_view newName) {
+        if (nameArena) {
+            name = nameArena->intern(newName);
+        } else {
+            std::unique_ptr<char[]> copy(new char[newName.size()]);
+            std::memcpy(copy.get(), newName.data(), newName.size());
+            ownedName = std::move(copy);
+            name = std::string_view(ownedName.get(), newName.size());
+        }
+    }
+
+    // Moves the name into arena; later names are interned there too
+    void useNameArena(StringArena& arena) {
+        nameArena = &arena;
+        name = arena.intern(name);
+        ownedName.reset();
+    }
+
+public:
+    User(const std::string& name, int id, int accessLevel) {
+        setName(name);
+        setId(id);
+        setAccessLevel(accessLevel);
+    }
+
+    // A copy owns its name, also when the original's name is in an arena
+    User(const User& other) : id(other.id), accessLevel(other.accessLevel), observer(other.observer) {
+        storeName(other.name);
+    }
+
+    User& operator=(const User& other) {
+        nameArena = nullptr;
+        storeName(other.name);
+        id = other.id;
+        accessLevel = other.accessLevel;
+        observer = other.observer;
+        return *this;
+    }
+
+    virtual ~User() = default;
+
+    // Getters
+    std::string_view getName() const { return name; }
+    int getId() const { return id; }
+    int getAccessLevel() const { return accessLevel; }
+
+    // Setters with validation
+    void setName(const std::string& newName) {
+        if (newName.empty()) {
+            throw std::invalid_argument("Имя не может быть пустым");
+        }
+        if (observer && newName != name) {
+            std::string oldName(name);
+            storeName(newName);
+            observer->onNameChanged(*this, oldName);
+        } else {
+            storeName(newName);
+        }
+    }
+
+    void setId(int newId) {
+        if (newId < 0) {
+            throw std::invalid_argument("ID не может быть отрицательным");
+        }
+        id = newId;
+    }
+
+    void setAccessLevel(int newAccessLevel) {
+        if (newAccessLevel < 0) {
+            throw std::invalid_argument("Уровень доступа не может быть отрицательным");
+        }
+        int oldAccessLevel = accessLevel;
+        accessLevel = newAccessLevel;
+        if (observer && oldAccessLevel != newAccessLevel) {
+            observer->onAccessLevelChanged(*this, oldAccessLevel);
+        }
+    }
+
+    // The system that owns the user is notified about access level and name
+    // changes; a user belongs to at most one system at a time
+    UserObserver* getObserver() const { return observer; }
+    void setObserver(UserObserver* newObserver) { observer = newObserver; }
+
+    virtual UserKind getKind() const { return UserKind::User; }
+
+    // Copy of the user that is not attached to any system
+    virtual std::shared_ptr<User> clone() const {
+        auto copy = std::make_shared<User>(*this);
+        copy->setObserver(nullptr);
+        return copy;
+    }
+
+protected:
+    void notifyAttributesChanged() {
+        if (observer) {
+            observer->onAttributesChanged(*this);
+        }
+    }
+
+public:
+    // Virtual method for polymorphism
+    virtual void displayInfo() const {
+        std::cout << "Пользователь: " << name << ", ID: " << id << ", Уровень доступа: " << accessLevel << std::endl;
+    }
+};
+
+// Derived Student class
+class Student : public User {
+private:
+    Symbol group;
+
+public:
+    Student(const std::string& name, int id, int accessLevel, const std::string& group)
+        : User(name, id, accessLevel), group(SymbolTable::global().intern(group)) {}
+
+    Student(const std::string& name, int id, int accessLevel, Symbol group)
+        : User(name, id, accessLevel), group(group) {}
+
+    void setGroup(const std::string& newGroup) {
+        if (newGroup.empty()) {
+            throw std::invalid_argument("Группа не может быть пустой");
+        }
+        group = SymbolTable::global().intern(newGroup);
+        notifyAttributesChanged();
+    }
+
+    const std::string& getGroup() const { return group.str(); }
+    Symbol getGroupSymbol() const { return group; }
+
+    UserKind getKind() const override { return UserKind::Student; }
+
+    std::shared_ptr<User> clone() const override {
+        auto copy = std::make_shared<Student>(*this);
+        copy->setObserver(nullptr);
+        return copy;
+    }
+
+    void displayInfo() const override {
+        std::cout << "Студент: " << getName() << ", ID: " << getId()
+                  << ", Уровень доступа: " << getAccessLevel() << ", Группа: " << group.str() << std::endl;
+    }
+};
+
+// Derived Teacher class
+class Teacher : public User {
+private:
+    Symbol department;
+
+public:
+    Teacher(const std::string& name, int id, int accessLevel, const std::string& department)
+        : User(name, id, accessLevel), department(SymbolTable::global().intern(department)) {}
+
+    Teacher(const std::string& name, int id, int accessLevel, Symbol department)
+        : User(name, id, accessLevel), department(department) {}
+
+    void setDepartment(const std::string& newDepartment) {
+        if (newDepartment.empty()) {
+            throw std::invalid_argument("Кафедра не может быть пустой");
+        }
+        department = SymbolTable::global().intern(newDepartment);
+        notifyAttributesChanged();
+    }
+
+    const std::string& getDepartment() const { return department.str(); }
+    Symbol getDepartmentSymbol() const { return department; }
+
+    UserKind getKind() const override { return UserKind::Teacher; }
+
+    std::shared_ptr<User> clone() const override {
+        auto copy = std::make_shared<Teacher>(*this);
+        copy->setObserver(nullptr);
+        return copy;
+    }
+
+    void displayInfo() const override {
+        std::cout << "Преподаватель: " << getName() << ", ID: " << getId()
+                  << ", Уровень доступа: " << getAccessLevel() << ", Кафедра: " << department.str() << std::endl;
+    }
+};
+
+// Derived Administrator class
+class Administrator : public User {
+private:
+    int adminLevel;
+
+public:
+    Administrator(const std::string& name, int id, int accessLevel, int adminLevel)
+        : User(name, id, accessLevel), adminLevel(adminLevel) {
+        if (adminLevel < 0) {
+            throw std::invalid_argument("Уровень администратора не может быть отрицательным");
+        }
+    }
+
+    void setAdminLevel(int newAdminLevel) {
+        if (newAdminLevel < 0) {
+            throw std::invalid_argument("Уровень администратора не может быть отрицательным");
+        }
+        adminLevel = newAdminLevel;
+        notifyAttributesChanged();
+    }
+
+    int getAdminLevel() const { return adminLevel; }
+
+    UserKind getKind() const override { return UserKind::Administrator; }
+
+    std::shared_ptr<User> clone() const override {
+        auto copy = std::make_shared<Administrator>(*this);
+        copy->setObserver(nullptr);
+        return copy;
+    }
+
+    void displayInfo() const override {
+        std::cout << "Администратор: " << getName() << ", ID: " << getId()
+                  << ", Уровень доступа: " << getAccessLevel() << ", Уровень администратора: " << adminLevel << std::endl;
+    }
+};
+
+// Where an AccessControlSystem allocates its users: one make_shared block
+// per user, or a UserArena shared by all users of a load
+enum class UserStorage : uint8_t {
+    Shared = 0,
+    Arena = 1
+};
+
+// Monotonic arena for the users of an AccessControlSystem in arena storage
+// mode. Users of all types are constructed back to back in large blocks,
+// never freed one by one, and their names are interned in the arena's
+// StringArena. The shared_ptr handed out for a user shares the arena's own
+// reference count (aliasing constructor) instead of a control block per
+// user, so the arena and all its users are destroyed together when the last
+// pointer to any of them goes away. create() locks, so parse threads may
+// share an arena. Create arenas with std::make_shared.
+class UserArena : public std::enable_shared_from_this<UserArena> {
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t blockUsed = BLOCK_SIZE;
+    std::vector<User*> objects;  // in construction order, destroyed in reverse
+    StringArena names;
+
+    void* allocate(size_t size, size_t alignment) {
+        size_t offset = (blockUsed + alignment - 1) / alignment * alignment;
+        if (offset > BLOCK_SIZE || BLOCK_SIZE - offset < size) {
+            blocks.emplace_back(new char[BLOCK_SIZE]);
+            offset = 0;
+        }
+        blockUsed = offset + size;
+        return blocks.back().get() + offset;
+    }
+
+public:
+    UserArena() = default;
+    UserArena(const UserArena&) = delete;
+    UserArena& operator=(const UserArena&) = delete;
+
+    ~UserArena() {
+        for (auto it = objects.rbegin(); it != objects.rend(); ++it) {
+            (*it)->~User();
+        }
+    }
+
+    template <typename T, typename... Args>
+    std::shared_ptr<T> create(Args&&... args) {
+        static_assert(std::is_base_of<User, T>::value, "UserArena holds users only");
+        static_assert(sizeof(T) <= BLOCK_SIZE && alignof(T) <= alignof(std::max_align_t),
+                      "user type does not fit an arena block");
+        T* user;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            void* memory = allocate(sizeof(T), alignof(T));
+            objects.push_back(nullptr);
+            try {
+                user = new (memory) T(std::forward<Args>(args)...);
+            } catch (...) {
+                objects.pop_back();
+                throw;
+            }
+            objects.back() = user;
+        }
+        user->useNameArena(names);
+        return std::shared_ptr<T>(shared_from_this(), user);
+    }
+
+    bool contains(const User& user) const {
+        return user.nameArena == &names;
+    }
+
+    size_t userCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return objects.size();
+    }
+
+    // Approximate bytes held: user blocks, the object table and the names
+    size_t memoryUsage() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return blocks.size() * BLOCK_SIZE + blocks.capacity() * sizeof(std::unique_ptr<char[]>) +
+               objects.capacity() * sizeof(User*) + names.memoryUsage();
+    }
+};
+
+// Approximate bytes of a user allocated with make_shared: the block with
+// both reference counts and the object and the heap buffer of the name,
+// each rounded up to the malloc granularity
+inline size_t sharedUserBytes(const User& user) {
+    const size_t controlBlock = 2 * sizeof(int) + sizeof(void*);
+    size_t objectSize = sizeof(User);
+    switch (user.getKind()) {
+        case UserKind::Student:
+            objectSize = sizeof(Student);
+            break;
+        case UserKind::Teacher:
+            objectSize = sizeof(Teacher);
+            break;
+        case UserKind::Administrator:
+            objectSize = sizeof(Administrator);
+            break;
+        case UserKind::User:
+            break;
+    }
+    return (controlBlock + objectSize + sizeof(size_t) + 15) / 16 * 16 +
+           (user.getName().size() + sizeof(size_t) + 15) / 16 * 16;
+}
+
+// Resource class representing university resources
+class Resource {
+private:
+    Symbol resourceName;
+    int requiredAccessLevel;
+
+public:
+    Resource(const std::string& name, int accessLevel)
+        : Resource(SymbolTable::global().intern(name), accessLevel) {}
+
+    Resource(Symbol name, int accessLevel)
+        : resourceName(name), requiredAccessLevel(accessLevel) {
+        if (name == Symbol()) {
+            throw std::invalid_argument("Имя ресурса не может быть пустым");
+        }
+        if (accessLevel < 0) {
+            throw std::invalid_argument("Уровень доступа не может быть отрицательным");
+        }
+    }
+
+    const std::string& getName() const { return resourceName.str(); }
+    Symbol getNameSymbol() const { return resourceName; }
+    int getRequiredAccessLevel() const { return requiredAccessLevel; }
+
+    bool checkAccess(const User& user) const {
+        return user.getAccessLevel() >= requiredAccessLevel;
+    }
+
+    void displayInfo() const {
+        std::cout << "Ресурс: " << resourceName.str() << ", Требуемый уровень доступа: " << requiredAccessLevel << std::endl;
+    }
+};
+
+// Binary snapshot layout (native little-endian byte order): header, user
+// records, user indices sorted by ID, resource records, resource indices
+// sorted by name, and a block of length-prefixed strings (uint32 length +
+// bytes) shared by all records. Records refer to strings by their offset in
+// the block, and equal strings are stored once. Version 2 appends the
+// sequence number of the last journal record to the header. Version 3 adds
+// the access policy: whether one is in effect and a table of its rules,
+// placed before the string block. Tables are found through the offsets in
+// the header, so files of earlier versions are still readable.
+const char SNAPSHOT_MAGIC[8] = {'A', 'C', 'S', 'N', 'A', 'P', '\0', '\0'};
+const uint32_t SNAPSHOT_VERSION = 3;
+const size_t SNAPSHOT_HEADER_V1_SIZE = 80;
+const size_t SNAPSHOT_HEADER_V2_SIZE = 88;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t userCount;
+    uint32_t resourceCount;
+    uint32_t reserved;
+    uint64_t usersOffset;
+    uint64_t userIdIndexOffset;
+    uint64_t resourcesOffset;
+    uint64_t resourceNameIndexOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    uint64_t fileSize;
+    uint64_t journalSequence;  // since version 2
+    uint64_t policyOffset;     // since version 3
+    uint32_t policyRuleCount;
+    uint32_t policyEnabled;    // 1 if an access policy is in effect
+};
+
+struct SnapshotUserRecord {
+    int32_t id;
+    int32_t accessLevel;
+    int32_t adminLevel;       // Administrator only
+    uint32_t nameOffset;
+    uint32_t extraOffset;     // group of a Student, department of a Teacher
+    uint8_t kind;             // UserKind
+    uint8_t padding[3];
+};
+
+struct SnapshotResourceRecord {
+    uint32_t nameOffset;
+    int32_t requiredAccessLevel;
+};
+
+struct SnapshotPolicyRecord {
+    uint8_t kind;               // PolicyRuleKind
+    uint8_t padding[3];
+    uint32_t attributeOffset;   // group or department of a grant
+    uint32_t resourceOffset;
+    int32_t minAdminLevel;      // admin override only
+};
+
+static_assert(sizeof(SnapshotHeader) == 104, "unexpected snapshot header layout");
+static_assert(sizeof(SnapshotUserRecord) == 24, "unexpected snapshot user record layout");
+static_assert(sizeof(SnapshotResourceRecord) == 8, "unexpected snapshot resource record layout");
+static_assert(sizeof(SnapshotPolicyRecord) == 16, "unexpected snapshot policy record layout");
+
+// Builds the shared string block of a snapshot
+class SnapshotStringBlock {
+private:
+    std::string data;
+    std::unordered_map<std::string, uint32_t> offsets;
+    std::vector<uint32_t> symbolOffsets;  // symbol ID -> offset + 1, or 0
+
+public:
+    // Interned strings are hashed once per symbol, not once per use
+    uint32_t add(Symbol symbol) {
+        if (symbol.id >= symbolOffsets.size()) {
+            symbolOffsets.resize(symbol.id + 1, 0);
+        }
+        if (symbolOffsets[symbol.id] == 0) {
+            symbolOffsets[symbol.id] = add(symbol.str()) + 1;
+        }
+        return symbolOffsets[symbol.id] - 1;
+    }
+
+    uint32_t add(const std::string& str) {
+        auto it = offsets.find(str);
+        if (it != offsets.end()) {
+            return it->second;
+        }
+        uint32_t offset = static_cast<uint32_t>(data.size());
+        uint32_t length = static_cast<uint32_t>(str.size());
+        data.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        data.append(str);
+        offsets.emplace(str, offset);
+        return offset;
+    }
+
+    const std::string& bytes() const { return data; }
+};
+
+// Read-only view of a snapshot file. The file is mapped into memory and
+// records are read in place, so opening it does not allocate per record.
+// Tables, indexes and string offsets are validated once when the file is
+// opened; lookups afterwards read the tables without further checks.
+class MappedSnapshot {
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    std::vector<char> buffer;  // used where mmap is not available
+    const SnapshotHeader* header = nullptr;
+    const SnapshotUserRecord* userRecords = nullptr;
+    const uint32_t* userIdIndex = nullptr;
+    const SnapshotResourceRecord* resourceRecords = nullptr;
+    const uint32_t* resourceNameIndex = nullptr;
+    const SnapshotPolicyRecord* policyRecords = nullptr;
+
+    void unmap() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (data && buffer.empty()) {
+            munmap(const_cast<char*>(data), size);
+        }
+#endif
+        data = nullptr;
+    }
+
+    template <typename T>
+    const T* table(uint64_t offset, uint32_t count) const {
+        if (offset > size || size - offset < static_cast<uint64_t>(count) * sizeof(T) ||
+            offset % alignof(T) != 0) {
+            throw std::runtime_error("Повреждённый файл снимка");
+        }
+        return reinterpret_cast<const T*>(data + offset);
+    }
+
+    void checkString(uint32_t offset) const {
+        uint32_t length;
+        if (offset > header->stringsSize || header->stringsSize - offset < sizeof(length)) {
+            throw std::runtime_error("Повреждённый файл снимка");
+        }
+        std::memcpy(&length, data + header->stringsOffset + offset, sizeof(length));
+        if (header->stringsSize - offset - sizeof(length) < length) {
+            throw std::runtime_error("Повреждённый файл снимка");
+        }
+    }
+
+    // Every record must refer to valid strings, and both indexes must refer
+    // to records in non-decreasing key order, so binary search finds each key
+    void validate() const {
+        for (uint32_t i = 0; i < header->userCount; ++i) {
+            const SnapshotUserRecord& record = userRecords[i];
+            checkString(record.nameOffset);
+            if (record.kind > static_cast<uint8_t>(UserKind::Administrator)) {
+                throw std::runtime_error("Неизвестный тип пользователя в снимке");
+            }
+            if (record.kind == static_cast<uint8_t>(UserKind::Student) ||
+                record.kind == static_cast<uint8_t>(UserKind::Teacher)) {
+                checkString(record.extraOffset);
+            }
+        }
+        for (uint32_t i = 0; i < header->resourceCount; ++i) {
+            checkString(resourceRecords[i].nameOffset);
+        }
+        for (uint32_t i = 0; i < policyRuleCount(); ++i) {
+            const SnapshotPolicyRecord& record = policyRecords[i];
+            checkString(record.resourceOffset);
+            if (record.kind == static_cast<uint8_t>(PolicyRuleKind::GroupGrant) ||
+                record.kind == static_cast<uint8_t>(PolicyRuleKind::DepartmentGrant)) {
+                checkString(record.attributeOffset);
+            } else if (record.kind != static_cast<uint8_t>(PolicyRuleKind::AdminOverride) || record.minAdminLevel < 0) {
+                throw std::runtime_error("Неверное правило политики доступа в снимке");
+            }
+        }
+        for (uint32_t i = 0; i < header->userCount; ++i) {
+            if (userIdIndex[i] >= header->userCount ||
+                (i > 0 && userRecords[userIdIndex[i - 1]].id > userRecords[userIdIndex[i]].id)) {
+                throw std::runtime_error("Повреждённый индекс пользователей в снимке");
+            }
+        }
+        for (uint32_t i = 0; i < header->resourceCount; ++i) {
+            if (resourceNameIndex[i] >= header->resourceCount ||
+                (i > 0 && string(resourceRecords[resourceNameIndex[i - 1]].nameOffset) >
+                          string(resourceRecords[resourceNameIndex[i]].nameOffset))) {
+                throw std::runtime_error("Повреждённый индекс ресурсов в снимке");
+            }
+        }
+    }
+
+public:
+    explicit MappedSnapshot(const std::string& filename) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Не удалось открыть файл снимка для чтения");
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("Не удалось открыть файл снимка для чтения");
+        }
+        size = static_cast<size_t>(st.st_size);
+        // Older versions have a shorter header; the size for the file's
+        // version is checked below, once the version has been read
+        if (size >= SNAPSHOT_HEADER_V1_SIZE) {
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Не удалось отобразить файл снимка в память");
+            }
+            data = static_cast<const char*>(mapped);
+        }
+        close(fd);
+#else
+        std::ifstream file(filename, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Не удалось открыть файл снимка для чтения");
+        }
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        size = buffer.size();
+        data = buffer.data();
+#endif
+        if (size < SNAPSHOT_HEADER_V1_SIZE) {
+            unmap();
+            throw std::runtime_error("Файл снимка слишком мал");
+        }
+        header = reinterpret_cast<const SnapshotHeader*>(data);
+        if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+            header->version < 1 || header->version > SNAPSHOT_VERSION ||
+            (header->version == 2 && size < SNAPSHOT_HEADER_V2_SIZE) ||
+            (header->version >= 3 && size < sizeof(SnapshotHeader)) || header->fileSize != size ||
+            header->stringsOffset > size || size - header->stringsOffset < header->stringsSize) {
+            unmap();
+            throw std::runtime_error("Неверный формат или версия файла снимка");
+        }
+        try {
+            userRecords = table<SnapshotUserRecord>(header->usersOffset, header->userCount);
+            userIdIndex = table<uint32_t>(header->userIdIndexOffset, header->userCount);
+            resourceRecords = table<SnapshotResourceRecord>(header->resourcesOffset, header->resourceCount);
+            resourceNameIndex = table<uint32_t>(header->resourceNameIndexOffset, header->resourceCount);
+            if (header->version >= 3) {
+                policyRecords = table<SnapshotPolicyRecord>(header->policyOffset, header->policyRuleCount);
+            }
+            validate();
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+
+    ~MappedSnapshot() {
+        unmap();
+    }
+
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+    uint32_t userCount() const { return header->userCount; }
+    uint32_t resourceCount() const { return header->resourceCount; }
+    uint64_t journalSequence() const { return header->version >= 2 ? header->journalSequence : 0; }
+
+    // Files before version 3 do not record the access policy
+    bool hasPolicy() const { return header->version >= 3; }
+    bool policyEnabled() const { return hasPolicy() && header->policyEnabled != 0; }
+    uint32_t policyRuleCount() const { return hasPolicy() ? header->policyRuleCount : 0; }
+
+    const SnapshotPolicyRecord& policyRecord(uint32_t index) const {
+        return policyRecords[index];
+    }
+
+    const SnapshotUserRecord& userRecord(uint32_t index) const {
+        return userRecords[index];
+    }
+
+    const SnapshotResourceRecord& resourceRecord(uint32_t index) const {
+        return resourceRecords[index];
+    }
+
+    // Offsets come from records validated at open
+    std::string_view string(uint32_t offset) const {
+        uint32_t length;
+        const char* str = data + header->stringsOffset + offset;
+        std::memcpy(&length, str, sizeof(length));
+        return std::string_view(str + sizeof(length), length);
+    }
+
+    // Binary search over the ID index; nullptr if there is no such user
+    const SnapshotUserRecord* findUser(int id) const {
+        const SnapshotUserRecord* records = userRecords;
+        const uint32_t* it = std::lower_bound(userIdIndex, userIdIndex + header->userCount, id,
+            [records](uint32_t i, int value) { return records[i].id < value; });
+        if (it != userIdIndex + header->userCount && records[*it].id == id) {
+            return &records[*it];
+        }
+        return nullptr;
+    }
+
+    // Binary search over the name index; nullptr if there is no such resource
+    const SnapshotResourceRecord* findResource(std::string_view name) const {
+        const SnapshotResourceRecord* records = resourceRecords;
+        const uint32_t* it = std::lower_bound(resourceNameIndex, resourceNameIndex + header->resourceCount, name,
+            [this, records](uint32_t i, std::string_view value) { return string(records[i].nameOffset) < value; });
+        if (it != resourceNameIndex + header->resourceCount && string(records[*it].nameOffset) == name) {
+            return &records[*it];
+        }
+        return nullptr;
+    }
+
+    bool checkUserAccessToResource(int userId, std::string_view resourceName) const {
+        const SnapshotUserRecord* user = findUser(userId);
+        if (!user) {
+            throw std::runtime_error("Пользователь не найден");
+        }
+        const SnapshotResourceRecord* resource = findResource(resourceName);
+        if (!resource) {
+            throw std::runtime_error("Ресурс не найден");
+        }
+        if (user->accessLevel >= resource->requiredAccessLevel) {
+            return true;
+        }
+        return policyEnabled() && policyAllows(*user, string(resource->nameOffset));
+    }
+
+    // Evaluates the stored rules as AccessPolicy::allows does for a user
+    // whose level is too low. The rule table is not indexed, so this is a
+    // scan over the rules.
+    bool policyAllows(const SnapshotUserRecord& user, std::string_view resourceName) const {
+        PolicyRuleKind ruleKind;
+        switch (static_cast<UserKind>(user.kind)) {
+            case UserKind::Student:
+                ruleKind = PolicyRuleKind::GroupGrant;
+                break;
+            case UserKind::Teacher:
+                ruleKind = PolicyRuleKind::DepartmentGrant;
+                break;
+            case UserKind::Administrator:
+                ruleKind = PolicyRuleKind::AdminOverride;
+                break;
+            default:
+                return false;
+        }
+        for (uint32_t i = 0; i < policyRuleCount(); ++i) {
+            const SnapshotPolicyRecord& rule = policyRecords[i];
+            if (rule.kind != static_cast<uint8_t>(ruleKind) || string(rule.resourceOffset) != resourceName) {
+                continue;
+            }
+            if (ruleKind == PolicyRuleKind::AdminOverride ? user.adminLevel >= rule.minAdminLevel
+                                                          : string(rule.attributeOffset) == string(user.extraOffset)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Per-phase timing of a parallel load, in milliseconds
+struct LoadTimings {
+    double readMs = 0;
+    double parseMs = 0;
+    double mergeMs = 0;
+    double indexMs = 0;
+    unsigned threads = 0;
+};
+
+// Reads a whole file with a single read call
+inline std::string readWholeFile(const std::string& filename, const char* errorMessage) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error(errorMessage);
+    }
+    std::string text(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(&text[0], static_cast<std::streamsize>(text.size()));
+    return text;
+}
+
+// Splits text into roughly equal chunks that end on a newline and parses
+// every line of a chunk with parseLine on a pool of worker threads.
+// Returns the parsed values of each chunk in file order.
+template <typename T, typename ParseLine>
+std::vector<std::vector<T>> parseLinesParallel(const std::string& text, unsigned threads, ParseLine parseLine) {
+    const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threads * 4, text.size() / 4096 + 1));
+    std::vector<size_t> bounds{0};
+    for (size_t i = 1; i < chunkCount; ++i) {
+        size_t pos = std::max(bounds.back(), text.size() * i / chunkCount);
+        pos = text.find('\n', pos);
+        if (pos == std::string::npos) {
+            break;
+        }
+        bounds.push_back(pos + 1);
+    }
+    bounds.push_back(text.size());
+
+    const size_t chunks = bounds.size() - 1;
+    std::vector<std::vector<T>> results(chunks);
+    std::vector<std::exception_ptr> errors(chunks);
+    std::atomic<size_t> nextChunk{0};
+
+    auto worker = [&]() {
+        size_t chunk;
+        while ((chunk = nextChunk.fetch_add(1)) < chunks) {
+            try {
+                const char* pos = text.data() + bounds[chunk];
+                const char* end = text.data() + bounds[chunk + 1];
+                while (pos < end) {
+                    const char* lineEnd = std::find(pos, end, '\n');
+                    parseLine(pos, lineEnd, results[chunk]);
+                    pos = lineEnd + 1;
+                }
+            } catch (...) {
+                errors[chunk] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return results;
+}
+
+// Splits a line of the text format into whitespace-separated fields
+inline size_t splitFields(const char* pos, const char* end, std::string_view* fields, size_t maxFields) {
+    size_t count = 0;
+    while (pos < end && count < maxFields) {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+            ++pos;
+        }
+        const char* start = pos;
+        while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r') {
+            ++pos;
+        }
+        if (pos > start) {
+            fields[count++] = std::string_view(start, pos - start);
+        }
+    }
+    return count;
+}
+
+inline int parseIntField(std::string_view field) {
+    int value = 0;
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    if (result.ec != std::errc() || result.ptr != field.data() + field.size()) {
+        throw std::runtime_error("Неверное число в файле: " + std::string(field));
+    }
+    return value;
+}
+
+// Flushes a file's data to the storage device where the platform allows it
+inline void syncFile(const std::string& filename) {
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#else
+    (void)filename;
+#endif
+}
+
+// Flushes the directory entry of a file, so a file created or renamed into
+// place survives a crash
+inline void syncParentDirectory(const std::string& filename) {
+#if defined(__unix__) || defined(__APPLE__)
+    std::string directory = std::filesystem::path(filename).parent_path().string();
+    int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#else
+    (void)filename;
+#endif
+}
+
+// Types of records in a MutationJournal
+enum class JournalRecordType : uint8_t {
+    AddUser = 1,
+    AddResource = 2,
+    SetAccessLevel = 3,
+    SetName = 4,
+    SetAttributes = 5,    // group, department or admin level of a user
+    SetPolicyRule = 6,    // grant or revoke one rule of the access policy
+    SetAccessPolicy = 7   // policy enabled (empty) or disabled
+};
+
+// Settings of a MutationJournal
+struct JournalOptions {
+    size_t groupCommitRecords = 1024;                            // fsync after this many records
+    std::chrono::milliseconds groupCommitInterval{10};           // or when the oldest pending record is this old
+    uint64_t compactAfterRecords = 1000000;                      // snapshot and truncate after this many
+};
+
+// Append-only journal of mutations. Every record is
+//   uint32 payload size, uint32 checksum, uint64 sequence, uint8 type, payload
+// where the FNV-1a checksum covers the sequence, type and payload. Records
+// are collected in memory and written and fsynced in groups (group commit);
+// commit() forces the pending group out. A flusher thread commits a group
+// once its oldest record is groupCommitInterval old, so the last records are
+// made durable even when no further mutation arrives. An error of the
+// flusher is reported by the next append or commit. On recovery, a torn or
+// corrupt record at the end of the file marks the end of the journal.
+class MutationJournal {
+private:
+    static const size_t RECORD_HEADER_SIZE = 17;
+
+    std::string filename;
+    JournalOptions options;
+    std::string pending;
+    size_t pendingRecords = 0;
+    uint64_t sequence = 0;
+    uint64_t recordsInFile = 0;
+    uint64_t committedSize = 0;  // file size after the last committed group
+    bool tornTail = false;       // a failed commit may have left part of a group in the file
+    std::chrono::steady_clock::time_point deadline;  // when the pending group must be committed
+
+    // Guards the pending group and the file, shared with the flusher thread
+    mutable std::mutex mutex;
+    std::condition_variable flusherWake;
+    std::thread flusher;
+    bool stopping = false;
+    std::exception_ptr flushError;
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = -1;
+#else
+    std::ofstream file;
+#endif
+
+    static uint32_t checksum(const char* data, size_t size) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+        }
+        return hash;
+    }
+
+    void openFile(bool truncate) {
+#if defined(__unix__) || defined(__APPLE__)
+        if (fd >= 0) {
+            close(fd);
+        }
+        fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0), 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Не удалось открыть журнал для записи");
+        }
+        off_t size = lseek(fd, 0, SEEK_END);
+        if (size < 0) {
+            throw std::runtime_error("Не удалось открыть журнал для записи");
+        }
+        committedSize = static_cast<uint64_t>(size);
+#else
+        file.close();
+        file.open(filename, std::ios::binary | (truncate ? std::ios::trunc : std::ios::app));
+        if (!file) {
+            throw std::runtime_error("Не удалось открыть журнал для записи");
+        }
+        std::error_code error;
+        committedSize = std::filesystem::file_size(filename, error);
+        if (error) {
+            throw std::runtime_error("Не удалось открыть журнал для записи");
+        }
+#endif
+        tornTail = false;
+    }
+
+    // Cuts the file back to the last committed group, so a retried group
+    // does not follow a torn copy of itself that replay would stop at
+    void cutTornTail() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (ftruncate(fd, static_cast<off_t>(committedSize)) != 0) {
+            throw std::runtime_error("Ошибка записи журнала");
+        }
+#else
+        file.close();
+        std::error_code error;
+        std::filesystem::resize_file(filename, committedSize, error);
+        if (error) {
+            throw std::runtime_error("Ошибка записи журнала");
+        }
+        openFile(false);
+#endif
+        tornTail = false;
+    }
+
+    void throwFlushError() {
+        if (flushError) {
+            std::exception_ptr error = flushError;
+            flushError = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            if (pending.empty() || flushError) {
+                flusherWake.wait(lock);
+            } else if (flusherWake.wait_until(lock, deadline) == std::cv_status::timeout &&
+                       !pending.empty() && std::chrono::steady_clock::now() >= deadline) {
+                try {
+                    commitLocked();
+                } catch (...) {
+                    flushError = std::current_exception();
+                }
+            }
+        }
+    }
+
+    // Writes the pending records with one write call and flushes them to disk.
+    // A failed commit keeps the group pending; the retry first cuts off
+    // whatever part of it reached the file.
+    void commitLocked() {
+        if (pending.empty()) {
+            return;
+        }
+        if (tornTail) {
+            cutTornTail();
+        }
+        tornTail = true;
+#if defined(__unix__) || defined(__APPLE__)
+        const char* data = pending.data();
+        size_t left = pending.size();
+        while (left > 0) {
+            ssize_t written = write(fd, data, left);
+            if (written < 0) {
+                throw std::runtime_error("Ошибка записи журнала");
+            }
+            data += written;
+            left -= static_cast<size_t>(written);
+        }
+        if (fsync(fd) != 0) {
+            throw std::runtime_error("Ошибка записи журнала на диск");
+        }
+#else
+        file.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+        file.flush();
+        if (!file) {
+            throw std::runtime_error("Ошибка записи журнала");
+        }
+#endif
+        tornTail = false;
+        committedSize += pending.size();
+        recordsInFile += pendingRecords;
+        pending.clear();
+        pendingRecords = 0;
+    }
+
+public:
+    // Decoded record passed to the replay callback
+    struct Record {
+        uint64_t sequence;
+        JournalRecordType type;
+        std::string_view payload;
+    };
+
+    // Opens the journal for appending after lastSequence, the sequence of
+    // the last record that was replayed or included in the snapshot
+    MutationJournal(const std::string& filename, uint64_t lastSequence, uint64_t recordsInFile,
+                    const JournalOptions& options)
+        : filename(filename), options(options), sequence(lastSequence), recordsInFile(recordsInFile) {
+        openFile(false);
+        if (options.groupCommitInterval.count() > 0 && options.groupCommitRecords > 1) {
+            flusher = std::thread([this]() { flushLoop(); });
+        }
+    }
+
+    ~MutationJournal() {
+        if (flusher.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            flusherWake.notify_one();
+            flusher.join();
+        }
+        try {
+            std::lock_guard<std::mutex> lock(mutex);
+            commitLocked();
+        } catch (...) {
+        }
+#if defined(__unix__) || defined(__APPLE__)
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    MutationJournal(const MutationJournal&) = delete;
+    MutationJournal& operator=(const MutationJournal&) = delete;
+
+    uint64_t lastSequence() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sequence;
+    }
+
+    uint64_t recordCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return recordsInFile + pendingRecords;
+    }
+
+    bool needsCompaction() const { return recordCount() >= options.compactAfterRecords; }
+
+    void append(JournalRecordType type, const std::string& payload) {
+        std::lock_guard<std::mutex> lock(mutex);
+        throwFlushError();
+        ++sequence;
+        char header[RECORD_HEADER_SIZE];
+        uint32_t size = static_cast<uint32_t>(payload.size());
+        std::memcpy(header, &size, 4);
+        std::memcpy(header + 8, &sequence, 8);
+        header[16] = static_cast<char>(type);
+        uint32_t hash = checksum(header + 8, 9);
+        for (char c : payload) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        std::memcpy(header + 4, &hash, 4);
+        pending.append(header, RECORD_HEADER_SIZE);
+        pending.append(payload);
+        ++pendingRecords;
+
+        auto now = std::chrono::steady_clock::now();
+        if (pendingRecords == 1) {
+            deadline = now + options.groupCommitInterval;
+            flusherWake.notify_one();
+        }
+        if (pendingRecords >= options.groupCommitRecords || now >= deadline) {
+            commitLocked();
+        }
+    }
+
+    // Forces the pending group out
+    void commit() {
+        std::lock_guard<std::mutex> lock(mutex);
+        throwFlushError();
+        commitLocked();
+    }
+
+    // Empties the journal once its records are covered by a snapshot
+    void truncate() {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.clear();
+        pendingRecords = 0;
+        recordsInFile = 0;
+        openFile(true);
+    }
+
+    // Calls apply for every valid record of the journal file in order and
+    // cuts off a torn or corrupt tail. Returns the number of valid records.
+    template <typename Apply>
+    static uint64_t replay(const std::string& filename, Apply apply) {
+        if (!std::filesystem::exists(filename)) {
+            return 0;
+        }
+        std::string data = readWholeFile(filename, "Не удалось открыть журнал для чтения");
+        size_t pos = 0;
+        uint64_t count = 0;
+        while (data.size() - pos >= RECORD_HEADER_SIZE) {
+            uint32_t size, hash;
+            Record record;
+            std::memcpy(&size, data.data() + pos, 4);
+            std::memcpy(&hash, data.data() + pos + 4, 4);
+            std::memcpy(&record.sequence, data.data() + pos + 8, 8);
+            record.type = static_cast<JournalRecordType>(data[pos + 16]);
+            if (data.size() - pos - RECORD_HEADER_SIZE < size ||
+                checksum(data.data() + pos + 8, 9 + size) != hash) {
+                break;
+            }
+            record.payload = std::string_view(data.data() + pos + RECORD_HEADER_SIZE, size);
+            apply(record);
+            pos += RECORD_HEADER_SIZE + size;
+            ++count;
+        }
+        if (pos < data.size()) {
+            std::filesystem::resize_file(filename, pos);
+        }
+        return count;
+    }
+};
+
+// Little-endian field encoding for journal payloads
+inline void putInt(std::string& out, int32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void putString(std::string& out, std::string_view value) {
+    uint32_t length = static_cast<uint32_t>(value.size());
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.append(value.data(), value.size());
+}
+
+// Reads fields written by putInt/putString, throwing on a short payload
+class PayloadReader {
+private:
+    std::string_view data;
+
+public:
+    explicit PayloadReader(std::string_view data) : data(data) {}
+
+    int32_t getInt() {
+        int32_t value;
+        if (data.size() < sizeof(value)) {
+            throw std::runtime_error("Повреждённая запись журнала");
+        }
+        std::memcpy(&value, data.data(), sizeof(value));
+        data.remove_prefix(sizeof(value));
+        return value;
+    }
+
+    uint8_t getByte() {
+        if (data.empty()) {
+            throw std::runtime_error("Повреждённая запись журнала");
+        }
+        uint8_t value = static_cast<uint8_t>(data[0]);
+        data.remove_prefix(1);
+        return value;
+    }
+
+    std::string getString() {
+        uint32_t length = static_cast<uint32_t>(getInt());
+        if (data.size() < length) {
+            throw std::runtime_error("Повреждённая запись журнала");
+        }
+        std::string value(data.substr(0, length));
+        data.remove_prefix(length);
+        return value;
+    }
+};
+
+// Recovery and compaction figures of a journal
+struct JournalStats {
+    uint64_t replayedRecords = 0;
+    double recoveryMs = 0;
+};
+
+// Length of the well-formed UTF-8 sequence at name[i], or 0 if the bytes
+// there are not one (stray continuation byte, truncated or overlong
+// sequence, surrogate or code point above U+10FFFF)
+inline size_t utf8SequenceLength(std::string_view name, size_t i) {
+    unsigned char c = static_cast<unsigned char>(name[i]);
+    size_t length;
+    unsigned char low = 0x80, high = 0xBF;  // allowed range of the second byte
+    if (c < 0x80) {
+        return 1;
+    } else if (c >= 0xC2 && c <= 0xDF) {
+        length = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        length = 3;
+        if (c == 0xE0) low = 0xA0;
+        if (c == 0xED) high = 0x9F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        length = 4;
+        if (c == 0xF0) low = 0x90;
+        if (c == 0xF4) high = 0x8F;
+    } else {
+        return 0;
+    }
+    if (name.size() - i < length) {
+        return 0;
+    }
+    for (size_t k = 1; k < length; ++k) {
+        unsigned char next = static_cast<unsigned char>(name[i + k]);
+        if (next < (k == 1 ? low : 0x80) || next > (k == 1 ? high : 0xBF)) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Splits a name into search tokens and normalizes them: ASCII and Cyrillic
+// letters are lowercased in UTF-8 and "ё" is folded to "е". Other characters
+// are kept as they are; bytes that are not well-formed UTF-8 are replaced
+// with U+FFFD, so tokens are always valid UTF-8.
+inline std::vector<std::string> nameTokens(std::string_view name) {
+    std::vector<std::string> tokens;
+    std::string token;
+    for (size_t i = 0; i < name.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(name[i]);
+        if (c == ' ' || c == '\t' || c == ',' || c == '.' || c == '-') {
+            if (!token.empty()) {
+                tokens.push_back(std::move(token));
+                token.clear();
+            }
+            continue;
+        }
+        if (c >= 'A' && c <= 'Z') {
+            token += static_cast<char>(c - 'A' + 'a');
+            continue;
+        }
+        size_t length = utf8SequenceLength(name, i);
+        if (length == 0) {
+            token += "\xEF\xBF\xBD";
+            continue;
+        }
+        if (c == 0xD0 || c == 0xD1) {
+            unsigned char next = static_cast<unsigned char>(name[i + 1]);
+            // Decode the two-byte sequence into a code point of U+0400..U+047F
+            unsigned codePoint = ((c & 0x1F) << 6) | (next & 0x3F);
+            if (codePoint >= 0x0410 && codePoint <= 0x042F) {
+                codePoint += 0x20;              // А..Я -> а..я
+            } else if (codePoint >= 0x0400 && codePoint <= 0x040F) {
+                codePoint += 0x50;              // Ѐ..Џ -> ѐ..џ
+            }
+            if (codePoint == 0x0451) {
+                codePoint = 0x0435;             // ё -> е
+            }
+            token += static_cast<char>(0xC0 | (codePoint >> 6));
+            token += static_cast<char>(0x80 | (codePoint & 0x3F));
+            ++i;
+            continue;
+        }
+        token.append(name.data() + i, length);
+        i += length - 1;
+    }
+    if (!token.empty()) {
+        tokens.push_back(std::move(token));
+    }
+    return tokens;
+}
+
+// Stable handle of a user of an AccessControlSystem: its number in insertion
+// order. Sorting or renaming users does not change it; like search results,
+// it is valid until the system's data is replaced by a load.
+struct UserHandle {
+    uint32_t number;
+};
+
+// Users found by an index query, as numbers into the system's users in
+// insertion order. A result owns its list of numbers, so adding or renaming
+// users does not change it, and iterating it does not touch reference counts.
+// It refers to the system's users, so it is valid until the system's data is
+// replaced by a load or the system is destroyed.
+template <typename UserType>
+class UserSearchResult {
+private:
+    const std::vector<std::shared_ptr<UserType>>* users = nullptr;
+    std::vector<uint32_t> numbers;
+
+public:
+    UserSearchResult() = default;
+    UserSearchResult(const std::vector<std::shared_ptr<UserType>>& users, std::vector<uint32_t> found)
+        : users(&users), numbers(std::move(found)) {}
+
+    size_t size() const { return numbers.size(); }
+    bool empty() const { return numbers.empty(); }
+
+    const UserType& operator[](size_t i) const {
+        return *pointer(i);
+    }
+
+    const std::shared_ptr<UserType>& pointer(size_t i) const {
+        return (*users)[numbers[i]];
+    }
+
+    UserHandle handle(size_t i) const {
+        return UserHandle{numbers[i]};
+    }
+};
+
+// Sorted insertion and removal of user numbers in a posting list
+inline void insertSortedNumber(std::vector<uint32_t>& postings, uint32_t number) {
+    if (postings.empty() || postings.back() < number) {
+        postings.push_back(number);
+    } else {
+        auto it = std::lower_bound(postings.begin(), postings.end(), number);
+        if (it == postings.end() || *it != number) {
+            postings.insert(it, number);
+        }
+    }
+}
+
+inline void eraseSortedNumber(std::vector<uint32_t>& postings, uint32_t number) {
+    auto it = std::lower_bound(postings.begin(), postings.end(), number);
+    if (it != postings.end() && *it == number) {
+        postings.erase(it);
+    }
+}
+
+// Inverted index over user names. Users are identified by their number in
+// insertion order; posting lists of full names and of normalized tokens hold
+// these numbers in ascending order, so they stay sorted when users are
+// appended and can be intersected with a linear merge. The token dictionary
+// is ordered, so prefix queries are a range scan.
+template <typename UserType>
+class UserNameIndex {
+private:
+    const std::vector<std::shared_ptr<UserType>>& usersByNumber;
+    std::unordered_map<std::string, std::vector<uint32_t>> fullNames;
+    std::map<std::string, std::vector<uint32_t>, std::less<>> tokens;
+
+    template <typename Map>
+    static void eraseFrom(Map& map, const std::string& key, uint32_t number) {
+        auto it = map.find(key);
+        if (it == map.end()) {
+            return;
+        }
+        eraseSortedNumber(it->second, number);
+        if (it->second.empty()) {
+            map.erase(it);
+        }
+    }
+
+    // Posting lists of the name tokens a query token matches
+    std::vector<const std::vector<uint32_t>*> postingsOf(const std::string& token, bool prefix) const {
+        std::vector<const std::vector<uint32_t>*> lists;
+        if (prefix) {
+            for (auto it = tokens.lower_bound(token);
+                 it != tokens.end() && it->first.compare(0, token.size(), token) == 0; ++it) {
+                lists.push_back(&it->second);
+            }
+        } else {
+            auto it = tokens.find(token);
+            if (it != tokens.end()) {
+                lists.push_back(&it->second);
+            }
+        }
+        return lists;
+    }
+
+public:
+    // usersByNumber is owned by the system and outlives the index
+    explicit UserNameIndex(const std::vector<std::shared_ptr<UserType>>& usersByNumber)
+        : usersByNumber(usersByNumber) {}
+
+    void add(uint32_t number, std::string_view name) {
+        insertSortedNumber(fullNames[std::string(name)], number);
+        for (auto& token : nameTokens(name)) {
+            insertSortedNumber(tokens[token], number);
+        }
+    }
+
+    void rename(uint32_t number, const std::string& oldName, std::string_view newName) {
+        eraseFrom(fullNames, oldName, number);
+        for (auto& token : nameTokens(oldName)) {
+            eraseFrom(tokens, token, number);
+        }
+        add(number, newName);
+    }
+
+    void clear() {
+        fullNames.clear();
+        tokens.clear();
+    }
+
+    // Users whose name is exactly name, in insertion order
+    UserSearchResult<UserType> findExact(const std::string& name) const {
+        auto it = fullNames.find(name);
+        if (it == fullNames.end()) {
+            return UserSearchResult<UserType>();
+        }
+        return UserSearchResult<UserType>(usersByNumber, it->second);
+    }
+
+    // Users whose name contains every token of the query (AND). With prefix
+    // set, a query token also matches name tokens that start with it.
+    UserSearchResult<UserType> findTokens(const std::string& query, bool prefix) const {
+        std::vector<std::string> queryTokens = nameTokens(query);
+        if (queryTokens.empty()) {
+            return UserSearchResult<UserType>();
+        }
+        std::vector<std::vector<const std::vector<uint32_t>*>> matched;
+        std::vector<size_t> totals;
+        for (const auto& token : queryTokens) {
+            matched.push_back(postingsOf(token, prefix));
+            size_t total = 0;
+            for (const auto* list : matched.back()) {
+                total += list->size();
+            }
+            if (total == 0) {
+                return UserSearchResult<UserType>();
+            }
+            totals.push_back(total);
+        }
+
+        // Start from the query token with the fewest postings
+        std::vector<size_t> order(matched.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&totals](size_t a, size_t b) { return totals[a] < totals[b]; });
+        const auto& first = matched[order[0]];
+        if (matched.size() == 1 && first.size() == 1) {
+            return UserSearchResult<UserType>(usersByNumber, *first[0]);
+        }
+        std::vector<uint32_t> result;
+        result.reserve(totals[order[0]]);
+        for (const auto* list : first) {
+            result.insert(result.end(), list->begin(), list->end());
+        }
+        if (first.size() > 1) {
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+        }
+
+        // Keep the candidates found in a posting list of every other query token
+        for (size_t k = 1; k < order.size() && !result.empty(); ++k) {
+            const auto& lists = matched[order[k]];
+            auto found = [&lists](uint32_t number) {
+                for (const auto* list : lists) {
+                    if (std::binary_search(list->begin(), list->end(), number)) {
+                        return true;
+                    }
+                }
+                return false;
+            };
+            result.erase(std::remove_if(result.begin(), result.end(),
+                                        [&found](uint32_t number) { return !found(number); }),
+                         result.end());
+        }
+        return UserSearchResult<UserType>(usersByNumber, std::move(result));
+    }
+};
+
+// Position of a paginated walk over an AccessLevelIndex
+struct AccessLevelCursor {
+    int level = 0;
+    uint32_t number = 0;
+    bool started = false;
+    bool finished = false;
+};
+
+// Secondary index of users ordered by access level: one bucket per level.
+// Buckets are unordered: a level change swap-removes the number from its
+// bucket and appends it to the new one in O(1), using the position of every
+// number in its bucket. A bucket that lost its order is sorted the next
+// time it is read, so reads still walk contiguous arrays in number order.
+class AccessLevelIndex {
+private:
+    static constexpr uint32_t NOT_INDEXED = UINT32_MAX;
+
+    struct Bucket {
+        std::vector<uint32_t> numbers;
+        bool sorted = true;
+    };
+
+    // Sorting on read reorders buckets and positions but not the contents
+    mutable std::map<int, Bucket> buckets;
+    mutable std::vector<uint32_t> positions;  // user number -> index in its bucket
+
+    const std::vector<uint32_t>& sortedNumbers(Bucket& bucket) const {
+        if (!bucket.sorted) {
+            std::sort(bucket.numbers.begin(), bucket.numbers.end());
+            for (uint32_t i = 0; i < bucket.numbers.size(); ++i) {
+                positions[bucket.numbers[i]] = i;
+            }
+            bucket.sorted = true;
+        }
+        return bucket.numbers;
+    }
+
+    void remove(uint32_t number, int level) {
+        // A wrong level finds another bucket, where the position may be out of range
+        auto it = buckets.find(level);
+        if (it == buckets.end() || number >= positions.size() || positions[number] == NOT_INDEXED ||
+            positions[number] >= it->second.numbers.size() ||
+            it->second.numbers[positions[number]] != number) {
+            throw std::logic_error("Пользователь отсутствует в индексе уровней");
+        }
+        std::vector<uint32_t>& numbers = it->second.numbers;
+        uint32_t position = positions[number];
+        if (position + 1 != numbers.size()) {
+            numbers[position] = numbers.back();
+            positions[numbers[position]] = position;
+            it->second.sorted = false;
+        }
+        numbers.pop_back();
+        positions[number] = NOT_INDEXED;
+        if (numbers.empty()) {
+            buckets.erase(it);
+        }
+    }
+
+public:
+    void add(uint32_t number, int level) {
+        if (number < positions.size() && positions[number] != NOT_INDEXED) {
+            throw std::invalid_argument("Пользователь уже есть в индексе уровней");
+        }
+        if (number >= positions.size()) {
+            positions.resize(number + 1, NOT_INDEXED);
+        }
+        Bucket& bucket = buckets[level];
+        if (!bucket.numbers.empty() && bucket.numbers.back() > number) {
+            bucket.sorted = false;
+        }
+        positions[number] = static_cast<uint32_t>(bucket.numbers.size());
+        bucket.numbers.push_back(number);
+    }
+
+    void move(uint32_t number, int oldLevel, int newLevel) {
+        remove(number, oldLevel);
+        add(number, newLevel);
+    }
+
+    void clear() {
+        buckets.clear();
+        positions.clear();
+    }
+
+    size_t countAtLeast(int minLevel) const {
+        size_t count = 0;
+        for (auto it = buckets.lower_bound(minLevel); it != buckets.end(); ++it) {
+            count += it->second.numbers.size();
+        }
+        return count;
+    }
+
+    // Numbers of users with level >= minLevel in (level, number) order,
+    // starting after the cursor; at most limit numbers per call
+    std::vector<uint32_t> page(int minLevel, AccessLevelCursor& cursor, size_t limit) const {
+        std::vector<uint32_t> result;
+        if (cursor.finished) {
+            return result;
+        }
+        auto bucket = buckets.lower_bound(cursor.started ? std::max(minLevel, cursor.level) : minLevel);
+        for (; bucket != buckets.end(); ++bucket) {
+            const std::vector<uint32_t>& numbers = sortedNumbers(bucket->second);
+            auto it = numbers.begin();
+            if (cursor.started && bucket->first == cursor.level) {
+                it = std::upper_bound(numbers.begin(), numbers.end(), cursor.number);
+            }
+            for (; it != numbers.end(); ++it) {
+                if (result.size() == limit) {
+                    return result;
+                }
+                result.push_back(*it);
+                cursor.level = bucket->first;
+                cursor.number = *it;
+                cursor.started = true;
+            }
+        }
+        cursor.finished = true;
+        return result;
+    }
+
+    // All user numbers in (level, number) order
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (auto& bucket : buckets) {
+            for (uint32_t number : sortedNumbers(bucket.second)) {
+                visit(number);
+            }
+        }
+    }
+};
+
+// Counters of an AccessDecisionCache
+struct AccessCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0;   // invalidateUser, invalidateResource and clear calls
+};
+
+// Bounded cache of access decisions keyed by (user ID, resource ID).
+// The table is set-associative: a key maps to one set of WAYS entries that
+// fills one cache line, and a full set evicts its least recently used entry,
+// so memory never grows and no allocation happens after construction.
+// Invalidation is O(1): every entry records the epoch it was inserted in,
+// and invalidating a user or resource stores a new epoch in its slot of a
+// fixed generation table. A lookup ignores entries older than the epochs of
+// their user, resource or the last clear. Users and resources that share a
+// generation slot are invalidated together, which only costs a miss.
+class AccessDecisionCache {
+private:
+    static const size_t WAYS = 4;
+
+    struct Entry {
+        int32_t userId;
+        int32_t resourceId;
+        uint32_t epoch;
+        uint16_t lastUse;   // ages are compared modulo 2^16, so LRU is approximate for very old entries
+        uint8_t valid;
+        uint8_t granted;
+    };
+
+    struct alignas(64) Set {
+        Entry ways[WAYS];
+    };
+
+    std::vector<Set> sets;
+    size_t setMask;
+    std::vector<uint32_t> userEpochs;      // epoch of the last invalidation per user slot
+    std::vector<uint32_t> resourceEpochs;  // epoch of the last invalidation per resource slot
+    size_t generationMask;
+    uint32_t epoch = 0;
+    uint32_t clearedEpoch = 0;
+    uint16_t tick = 0;
+    AccessCacheStats counters;
+
+    Entry* setOf(int userId, int resourceId) {
+        uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(userId)) << 32) | static_cast<uint32_t>(resourceId);
+        key *= 0x9E3779B97F4A7C15ull;
+        return sets[(key >> 32) & setMask].ways;
+    }
+
+    uint32_t& userEpoch(int userId) {
+        uint64_t key = static_cast<uint32_t>(userId) * 0x9E3779B97F4A7C15ull;
+        return userEpochs[(key >> 32) & generationMask];
+    }
+
+    uint32_t& resourceEpoch(int resourceId) {
+        // Resource IDs are dense indexes, so they spread over the slots as they are
+        return resourceEpochs[static_cast<uint32_t>(resourceId) & generationMask];
+    }
+
+    bool live(const Entry& entry) {
+        return entry.valid && entry.epoch >= clearedEpoch && entry.epoch >= userEpoch(entry.userId) &&
+               entry.epoch >= resourceEpoch(entry.resourceId);
+    }
+
+    // Starts a new epoch; when the counter would wrap, all entries are
+    // dropped and the epochs start over
+    uint32_t nextEpoch() {
+        if (epoch == UINT32_MAX) {
+            for (auto& set : sets) {
+                for (auto& entry : set.ways) {
+                    entry.valid = 0;
+                }
+            }
+            std::fill(userEpochs.begin(), userEpochs.end(), 0);
+            std::fill(resourceEpochs.begin(), resourceEpochs.end(), 0);
+            epoch = 0;
+            clearedEpoch = 0;
+        }
+        return ++epoch;
+    }
+
+public:
+    // Capacity is rounded up to a power of two number of sets
+    explicit AccessDecisionCache(size_t capacity) {
+        size_t setCount = 1;
+        while (setCount * WAYS < capacity) {
+            setCount *= 2;
+        }
+        setMask = setCount - 1;
+        sets.assign(setCount, Set{});
+        const size_t generationSlots = std::max<size_t>(setCount, 64);
+        generationMask = generationSlots - 1;
+        userEpochs.assign(generationSlots, 0);
+        resourceEpochs.assign(generationSlots, 0);
+    }
+
+    size_t capacity() const { return sets.size() * WAYS; }
+    const AccessCacheStats& stats() const { return counters; }
+
+    bool lookup(int userId, int resourceId, bool& granted) {
+        Entry* set = setOf(userId, resourceId);
+        for (size_t way = 0; way < WAYS; ++way) {
+            Entry& entry = set[way];
+            if (entry.valid && entry.userId == userId && entry.resourceId == resourceId) {
+                if (!live(entry)) {
+                    entry.valid = 0;
+                    break;
+                }
+                entry.lastUse = ++tick;
+                granted = entry.granted;
+                ++counters.hits;
+                return true;
+            }
+        }
+        ++counters.misses;
+        return false;
+    }
+
+    void insert(int userId, int resourceId, bool granted) {
+        Entry* set = setOf(userId, resourceId);
+        Entry* victim = &set[0];
+        for (size_t way = 0; way < WAYS; ++way) {
+            Entry& entry = set[way];
+            if (!live(entry) || (entry.userId == userId && entry.resourceId == resourceId)) {
+                victim = &entry;
+                break;
+            }
+            if (static_cast<uint16_t>(tick - entry.lastUse) > static_cast<uint16_t>(tick - victim->lastUse)) {
+                victim = &entry;
+            }
+        }
+        if (live(*victim) && (victim->userId != userId || victim->resourceId != resourceId)) {
+            ++counters.evictions;
+        }
+        *victim = Entry{userId, resourceId, epoch, ++tick, 1, static_cast<uint8_t>(granted)};
+    }
+
+    void invalidateUser(int userId) {
+        uint32_t now = nextEpoch();
+        userEpoch(userId) = now;
+        ++counters.invalidations;
+    }
+
+    void invalidateResource(int resourceId) {
+        uint32_t now = nextEpoch();
+        resourceEpoch(resourceId) = now;
+        ++counters.invalidations;
+    }
+
+    void clear() {
+        clearedEpoch = nextEpoch();
+        ++counters.invalidations;
+    }
+};
+
+// Attributes of a user that access rules depend on. Users with equal keys
+// form one principal class and always get the same access decisions.
+struct PrincipalKey {
+    UserKind kind = UserKind::User;
+    int accessLevel = 0;
+    int adminLevel = 0;
+    Symbol attribute;  // group of a student or department of a teacher
+
+    static PrincipalKey of(const User& user) {
+        PrincipalKey key;
+        key.kind = user.getKind();
+        key.accessLevel = user.getAccessLevel();
+        switch (key.kind) {
+            case UserKind::Student:
+                key.attribute = static_cast<const Student&>(user).getGroupSymbol();
+                break;
+            case UserKind::Teacher:
+                key.attribute = static_cast<const Teacher&>(user).getDepartmentSymbol();
+                break;
+            case UserKind::Administrator:
+                key.adminLevel = static_cast<const Administrator&>(user).getAdminLevel();
+                break;
+            case UserKind::User:
+                break;
+        }
+        return key;
+    }
+
+    // 13 bytes, short enough to stay inside the std::string object
+    std::string encode() const {
+        std::string encoded;
+        encoded += static_cast<char>(kind);
+        encoded.append(reinterpret_cast<const char*>(&accessLevel), sizeof(accessLevel));
+        encoded.append(reinterpret_cast<const char*>(&adminLevel), sizeof(adminLevel));
+        encoded.append(reinterpret_cast<const char*>(&attribute.id), sizeof(attribute.id));
+        return encoded;
+    }
+};
+
+// Access rules on top of the required access level: resources granted to
+// whole student groups and teacher departments, and the admin level from
+// which administrators open a resource regardless of their access level
+class AccessPolicy {
+private:
+    // Grants as (group or department symbol, resource name symbol) pairs
+    std::unordered_set<uint64_t> groupGrants;
+    std::unordered_set<uint64_t> departmentGrants;
+    std::unordered_map<uint32_t, int> adminOverrides;
+
+    static uint64_t grantKey(Symbol attribute, Symbol resourceName) {
+        return (uint64_t(attribute.id) << 32) | resourceName.id;
+    }
+
+    static Symbol intern(const std::string& str) {
+        return SymbolTable::global().intern(str);
+    }
+
+    // Removals look strings up without interning them: a string that was
+    // never interned cannot be part of a rule
+    static bool find(const std::string& str, Symbol& symbol) {
+        return SymbolTable::global().find(str, symbol);
+    }
+
+public:
+    void grantGroup(const std::string& group, const std::string& resourceName) {
+        groupGrants.insert(grantKey(intern(group), intern(resourceName)));
+    }
+
+    void revokeGroup(const std::string& group, const std::string& resourceName) {
+        Symbol groupSymbol, resourceSymbol;
+        if (find(group, groupSymbol) && find(resourceName, resourceSymbol)) {
+            groupGrants.erase(grantKey(groupSymbol, resourceSymbol));
+        }
+    }
+
+    void grantDepartment(const std::string& department, const std::string& resourceName) {
+        departmentGrants.insert(grantKey(intern(department), intern(resourceName)));
+    }
+
+    void revokeDepartment(const std::string& department, const std::string& resourceName) {
+        Symbol departmentSymbol, resourceSymbol;
+        if (find(department, departmentSymbol) && find(resourceName, resourceSymbol)) {
+            departmentGrants.erase(grantKey(departmentSymbol, resourceSymbol));
+        }
+    }
+
+    void setAdminOverride(const std::string& resourceName, int minAdminLevel) {
+        if (minAdminLevel < 0) {
+            throw std::invalid_argument("Уровень администратора не может быть отрицательным");
+        }
+        adminOverrides[intern(resourceName).id] = minAdminLevel;
+    }
+
+    void clearAdminOverride(const std::string& resourceName) {
+        Symbol resourceSymbol;
+        if (find(resourceName, resourceSymbol)) {
+            adminOverrides.erase(resourceSymbol.id);
+        }
+    }
+
+    // Evaluates the rules for one principal and resource
+    bool allows(const PrincipalKey& key, Symbol resourceName, int requiredAccessLevel) const {
+        if (key.accessLevel >= requiredAccessLevel) {
+            return true;
+        }
+        switch (key.kind) {
+            case UserKind::Student:
+                return groupGrants.count(grantKey(key.attribute, resourceName)) != 0;
+            case UserKind::Teacher:
+                return departmentGrants.count(grantKey(key.attribute, resourceName)) != 0;
+            case UserKind::Administrator: {
+                auto it = adminOverrides.find(resourceName.id);
+                return it != adminOverrides.end() && key.adminLevel >= it->second;
+            }
+            case UserKind::User:
+                break;
+        }
+        return false;
+    }
+
+    bool allows(const User& user, const Resource& resource) const {
+        return allows(PrincipalKey::of(user), resource.getNameSymbol(), resource.getRequiredAccessLevel());
+    }
+
+    // Calls visit(kind, attribute, resourceName, minAdminLevel) for every
+    // rule; attribute is empty and minAdminLevel is set for admin overrides
+    template <typename Visit>
+    void forEachRule(Visit visit) const {
+        for (uint64_t key : groupGrants) {
+            visit(PolicyRuleKind::GroupGrant, Symbol{static_cast<uint32_t>(key >> 32)},
+                  Symbol{static_cast<uint32_t>(key)}, 0);
+        }
+        for (uint64_t key : departmentGrants) {
+            visit(PolicyRuleKind::DepartmentGrant, Symbol{static_cast<uint32_t>(key >> 32)},
+                  Symbol{static_cast<uint32_t>(key)}, 0);
+        }
+        for (const auto& entry : adminOverrides) {
+            visit(PolicyRuleKind::AdminOverride, Symbol(), Symbol{entry.first}, entry.second);
+        }
+    }
+};
+
+// AccessPolicy compiled into a dense bit matrix of principal classes x
+// resources, so that a check is a single bit test. The matrix is kept up to
+// date incrementally: a new principal class compiles one row, a new resource
+// or a rule change compiles one column. Classes are never removed, so the
+// matrix grows with the number of distinct keys ever seen until clear().
+class PermissionMatrix {
+private:
+    struct Column {
+        Symbol name;
+        int requiredAccessLevel;
+    };
+
+    AccessPolicy policy;
+    std::vector<Column> columns;
+    std::unordered_map<uint32_t, std::vector<int>> columnsByName;
+    std::vector<PrincipalKey> classes;
+    std::unordered_map<std::string, uint32_t> classIds;
+    std::vector<uint64_t> bits;
+    size_t stride = 1;  // 64-bit words per row
+
+    void compileCell(uint32_t principalClass, int column) {
+        uint64_t& word = bits[principalClass * stride + column / 64];
+        const uint64_t mask = uint64_t(1) << (column % 64);
+        if (policy.allows(classes[principalClass], columns[column].name, columns[column].requiredAccessLevel)) {
+            word |= mask;
+        } else {
+            word &= ~mask;
+        }
+    }
+
+    void compileColumns(const std::string& resourceName) {
+        Symbol resourceSymbol;
+        if (!SymbolTable::global().find(resourceName, resourceSymbol)) {
+            return;
+        }
+        auto it = columnsByName.find(resourceSymbol.id);
+        if (it == columnsByName.end()) {
+            return;
+        }
+        for (int column : it->second) {
+            for (uint32_t c = 0; c < classes.size(); ++c) {
+                compileCell(c, column);
+            }
+        }
+    }
+
+public:
+    explicit PermissionMatrix(const AccessPolicy& policy = AccessPolicy()) : policy(policy) {}
+
+    const AccessPolicy& getPolicy() const { return policy; }
+
+    // Principal class of the user; a class seen for the first time gets its row compiled
+    uint32_t classify(const User& user) {
+        PrincipalKey key = PrincipalKey::of(user);
+        auto inserted = classIds.emplace(key.encode(), static_cast<uint32_t>(classes.size()));
+        if (inserted.second) {
+            uint32_t principalClass = inserted.first->second;
+            classes.push_back(std::move(key));
+            bits.resize(classes.size() * stride, 0);
+            for (int column = 0; column < static_cast<int>(columns.size()); ++column) {
+                compileCell(principalClass, column);
+            }
+        }
+        return inserted.first->second;
+    }
+
+    // Appends the resource as the next column (columns follow resource IDs)
+    void addResource(const Resource& resource) {
+        int column = static_cast<int>(columns.size());
+        if (static_cast<size_t>(column) == stride * 64) {
+            // Rows are widened by doubling, so appending columns is amortized O(classes)
+            std::vector<uint64_t> wider(classes.size() * stride * 2, 0);
+            for (size_t c = 0; c < classes.size(); ++c) {
+                std::copy(bits.begin() + c * stride, bits.begin() + (c + 1) * stride, wider.begin() + c * stride * 2);
+            }
+            bits.swap(wider);
+            stride *= 2;
+        }
+        columns.push_back(Column{resource.getNameSymbol(), resource.getRequiredAccessLevel()});
+        columnsByName[resource.getNameSymbol().id].push_back(column);
+        for (uint32_t c = 0; c < classes.size(); ++c) {
+            compileCell(c, column);
+        }
+    }
+
+    // Rule changes recompile the columns of the affected resource only
+    void grantGroup(const std::string& group, const std::string& resourceName) {
+        policy.grantGroup(group, resourceName);
+        compileColumns(resourceName);
+    }
+
+    void revokeGroup(const std::string& group, const std::string& resourceName) {
+        policy.revokeGroup(group, resourceName);
+        compileColumns(resourceName);
+    }
+
+    void grantDepartment(const std::string& department, const std::string& resourceName) {
+        policy.grantDepartment(department, resourceName);
+        compileColumns(resourceName);
+    }
+
+    void revokeDepartment(const std::string& department, const std::string& resourceName) {
+        policy.revokeDepartment(department, resourceName);
+        compileColumns(resourceName);
+    }
+
+    void setAdminOverride(const std::string& resourceName, int minAdminLevel) {
+        policy.setAdminOverride(resourceName, minAdminLevel);
+        compileColumns(resourceName);
+    }
+
+    void clearAdminOverride(const std::string& resourceName) {
+        policy.clearAdminOverride(resourceName);
+        compileColumns(resourceName);
+    }
+
+    bool allowed(uint32_t principalClass, int resourceId) const {
+        return (bits[principalClass * stride + static_cast<size_t>(resourceId) / 64] >> (resourceId % 64)) & 1;
+    }
+
+    // Drops all classes and columns; the rules are kept
+    void clear() {
+        columns.clear();
+        columnsByName.clear();
+        classes.clear();
+        classIds.clear();
+        bits.clear();
+        stride = 1;
+    }
+
+    size_t classCount() const { return classes.size(); }
+    size_t matrixBytes() const { return bits.size() * sizeof(uint64_t); }
+};
+
+// Result of a batch access check: one bit per checked pair in each bitmap
+struct AccessBatchResult {
+    size_t size = 0;
+    std::vector<uint64_t> granted;
+    std::vector<uint64_t> missing;  // user or resource was not found
+
+    bool isGranted(size_t i) const { return (granted[i / 64] >> (i % 64)) & 1; }
+    bool isMissing(size_t i) const { return (missing[i / 64] >> (i % 64)) & 1; }
+};
+
+// Template class AccessControlSystem to manage users and resources
+template <typename UserType, typename ResourceType>
+class AccessControlSystem : private UserObserver {
+private:
+    std::vector<std::shared_ptr<UserType>> users;
+    std::vector<std::shared_ptr<ResourceType>> resources;
+
+    // Indexed user: the pointer survives reordering of users, the slot
+    // addresses its access level in userLevels, the number is its handle
+    struct UserEntry {
+        std::shared_ptr<UserType> user;
+        uint32_t slot;
+        uint32_t number;
+    };
+
+    // Arena storage mode: users of the current data set and users added
+    // since come from one arena; every load starts a new one
+    UserStorage storage;
+    std::shared_ptr<UserArena> arena;
+
+    // Hash indexes for O(1) lookups. Resources are never reordered, so they
+    // are indexed by position, which also serves as the resource ID in batch checks
+    std::unordered_map<int, UserEntry> usersById;
+    std::unordered_map<std::string, int> resourcesByName;
+    // Per symbol shard: index in the shard -> resource ID, or -1
+    std::array<std::vector<int32_t>, SymbolTable::SHARDS> resourcesBySymbol;
+
+    // Packed copies of access levels (structure of arrays) for batch checks
+    std::vector<int32_t> userLevels;
+    std::vector<int32_t> resourceLevels;
+
+    // Every user gets a number in insertion order; secondary indexes refer
+    // to users by these numbers
+    std::vector<std::shared_ptr<UserType>> usersByNumber;
+    std::unordered_map<const User*, uint32_t> userNumbers;
+    UserNameIndex<UserType> nameIndex{usersByNumber};
+    AccessLevelIndex levelIndex;
+
+    // Optional cache of access decisions; checks fill it, so it is mutable
+    mutable std::unique_ptr<AccessDecisionCache> decisionCache;
+
+    // Optional compiled access policy and the principal class of every slot
+    std::unique_ptr<PermissionMatrix> permissions;
+    std::vector<uint32_t> userClasses;
+
+    // Optional journal of mutations and the snapshot it is compacted into
+    std::unique_ptr<MutationJournal> journal;
+    std::string journalSnapshotFile;
+
+    void journalUser(const UserType& user) {
+        std::string payload;
+        payload += static_cast<char>(user.getKind());
+        putInt(payload, user.getId());
+        putInt(payload, user.getAccessLevel());
+        switch (user.getKind()) {
+            case UserKind::Student:
+                putInt(payload, 0);
+                putString(payload, user.getName());
+                putString(payload, static_cast<const Student&>(user).getGroup());
+                break;
+            case UserKind::Teacher:
+                putInt(payload, 0);
+                putString(payload, user.getName());
+                putString(payload, static_cast<const Teacher&>(user).getDepartment());
+                break;
+            case UserKind::Administrator:
+                putInt(payload, static_cast<const Administrator&>(user).getAdminLevel());
+                putString(payload, user.getName());
+                putString(payload, std::string());
+                break;
+            case UserKind::User:
+                putInt(payload, 0);
+                putString(payload, user.getName());
+                putString(payload, std::string());
+                break;
+        }
+        appendToJournal(JournalRecordType::AddUser, payload);
+    }
+
+    void appendToJournal(JournalRecordType type, const std::string& payload) {
+        journal->append(type, payload);
+        if (journal->needsCompaction()) {
+            compactJournal();
+        }
+    }
+
+    void journalPolicyRule(PolicyRuleKind kind, bool granted, const std::string& attribute,
+                           const std::string& resourceName, int minAdminLevel) {
+        if (!journal) {
+            return;
+        }
+        std::string payload;
+        payload += static_cast<char>(kind);
+        payload += static_cast<char>(granted);
+        putInt(payload, minAdminLevel);
+        putString(payload, attribute);
+        putString(payload, resourceName);
+        appendToJournal(JournalRecordType::SetPolicyRule, payload);
+    }
+
+    void journalAccessPolicy(const PermissionMatrix* matrix) {
+        if (!journal) {
+            return;
+        }
+        std::string payload;
+        payload += static_cast<char>(matrix != nullptr);
+        appendToJournal(JournalRecordType::SetAccessPolicy, payload);
+        if (matrix) {
+            matrix->getPolicy().forEachRule([this](PolicyRuleKind kind, Symbol attribute, Symbol resourceName, int level) {
+                journalPolicyRule(kind, true, attribute.str(), resourceName.str(), level);
+            });
+        }
+    }
+
+    // Detaches the journal while a loader replaces all data and compacts it
+    // afterwards, since a bulk load is not expressed as journal records. If
+    // the loader throws, the journal is reattached without compaction, so the
+    // snapshot and journal on disk keep the last durable state.
+    class JournalSuspension {
+    private:
+        AccessControlSystem& system;
+        std::unique_ptr<MutationJournal> journal;
+        int uncaughtExceptions;
+
+    public:
+        explicit JournalSuspension(AccessControlSystem& system)
+            : system(system), journal(std::move(system.journal)), uncaughtExceptions(std::uncaught_exceptions()) {}
+
+        ~JournalSuspension() {
+            if (journal) {
+                system.journal = std::move(journal);
+                if (std::uncaught_exceptions() > uncaughtExceptions) {
+                    return;
+                }
+                try {
+                    system.compactJournal();
+                } catch (const std::exception& e) {
+                    std::cerr << "Ошибка сжатия журнала: " << e.what() << std::endl;
+                }
+            }
+        }
+    };
+
+    // Applies one journal record during recovery
+    void applyJournalRecord(const MutationJournal::Record& record) {
+        PayloadReader reader(record.payload);
+        switch (record.type) {
+            case JournalRecordType::AddUser: {
+                UserKind kind = static_cast<UserKind>(reader.getByte());
+                int id = reader.getInt();
+                int accessLevel = reader.getInt();
+                int adminLevel = reader.getInt();
+                std::string name = reader.getString();
+                std::string extra = reader.getString();
+                switch (kind) {
+                    case UserKind::Student:
+                        addUser(createUser<Student>(name, id, accessLevel, extra));
+                        break;
+                    case UserKind::Teacher:
+                        addUser(createUser<Teacher>(name, id, accessLevel, extra));
+                        break;
+                    case UserKind::Administrator:
+                        addUser(createUser<Administrator>(name, id, accessLevel, adminLevel));
+                        break;
+                    case UserKind::User:
+                        addUser(createUser<User>(name, id, accessLevel));
+                        break;
+                    default:
+                        throw std::runtime_error("Неизвестный тип пользователя в журнале");
+                }
+                break;
+            }
+            case JournalRecordType::AddResource: {
+                int accessLevel = reader.getInt();
+                std::string name = reader.getString();
+                addResource(std::make_shared<Resource>(name, accessLevel));
+                break;
+            }
+            case JournalRecordType::SetAccessLevel: {
+                int id = reader.getInt();
+                int accessLevel = reader.getInt();
+                auto it = usersById.find(id);
+                if (it != usersById.end()) {
+                    it->second.user->setAccessLevel(accessLevel);
+                }
+                break;
+            }
+            case JournalRecordType::SetName: {
+                int id = reader.getInt();
+                std::string name = reader.getString();
+                auto it = usersById.find(id);
+                if (it != usersById.end()) {
+                    it->second.user->setName(name);
+                }
+                break;
+            }
+            case JournalRecordType::SetAttributes: {
+                int id = reader.getInt();
+                int adminLevel = reader.getInt();
+                std::string extra = reader.getString();
+                auto it = usersById.find(id);
+                if (it == usersById.end()) {
+                    break;
+                }
+                UserType& user = *it->second.user;
+                switch (user.getKind()) {
+                    case UserKind::Student:
+                        static_cast<Student&>(user).setGroup(extra);
+                        break;
+                    case UserKind::Teacher:
+                        static_cast<Teacher&>(user).setDepartment(extra);
+                        break;
+                    case UserKind::Administrator:
+                        static_cast<Administrator&>(user).setAdminLevel(adminLevel);
+                        break;
+                    case UserKind::User:
+                        break;
+                }
+                break;
+            }
+            case JournalRecordType::SetPolicyRule: {
+                PolicyRuleKind kind = static_cast<PolicyRuleKind>(reader.getByte());
+                bool granted = reader.getByte() != 0;
+                int minAdminLevel = reader.getInt();
+                std::string attribute = reader.getString();
+                std::string resourceName = reader.getString();
+                switch (kind) {
+                    case PolicyRuleKind::GroupGrant:
+                        granted ? grantGroupAccess(attribute, resourceName) : revokeGroupAccess(attribute, resourceName);
+                        break;
+                    case PolicyRuleKind::DepartmentGrant:
+                        granted ? grantDepartmentAccess(attribute, resourceName)
+                                : revokeDepartmentAccess(attribute, resourceName);
+                        break;
+                    case PolicyRuleKind::AdminOverride:
+                        granted ? setAdminOverride(resourceName, minAdminLevel) : clearAdminOverride(resourceName);
+                        break;
+                    default:
+                        throw std::runtime_error("Неизвестное правило политики доступа в журнале");
+                }
+                break;
+            }
+            case JournalRecordType::SetAccessPolicy: {
+                if (reader.getByte() != 0) {
+                    setAccessPolicy(AccessPolicy());
+                } else {
+                    clearAccessPolicy();
+                }
+                break;
+            }
+            default:
+                throw std::runtime_error("Неизвестный тип записи журнала");
+        }
+    }
+
+    void onAccessLevelChanged(const User& user, int oldAccessLevel) override {
+        auto number = userNumbers.find(&user);
+        if (number != userNumbers.end()) {
+            levelIndex.move(number->second, oldAccessLevel, user.getAccessLevel());
+        }
+        auto it = usersById.find(user.getId());
+        if (it != usersById.end() && it->second.user.get() == &user) {
+            userLevels[it->second.slot] = user.getAccessLevel();
+            if (permissions) {
+                userClasses[it->second.slot] = permissions->classify(user);
+            }
+            if (decisionCache) {
+                decisionCache->invalidateUser(user.getId());
+            }
+            // Users shadowed by an earlier user with the same ID cannot be
+            // addressed on replay, so only the indexed user is journaled
+            if (journal) {
+                std::string payload;
+                putInt(payload, user.getId());
+                putInt(payload, user.getAccessLevel());
+                appendToJournal(JournalRecordType::SetAccessLevel, payload);
+            }
+        }
+    }
+
+    void onNameChanged(const User& user, const std::string& oldName) override {
+        auto number = userNumbers.find(&user);
+        if (number != userNumbers.end()) {
+            nameIndex.rename(number->second, oldName, user.getName());
+        }
+        auto it = usersById.find(user.getId());
+        if (journal && it != usersById.end() && it->second.user.get() == &user) {
+            std::string payload;
+            putInt(payload, user.getId());
+            putString(payload, user.getName());
+            appendToJournal(JournalRecordType::SetName, payload);
+        }
+    }
+
+    void onAttributesChanged(const User& user) override {
+        auto it = usersById.find(user.getId());
+        if (it != usersById.end() && it->second.user.get() == &user) {
+            if (permissions) {
+                userClasses[it->second.slot] = permissions->classify(user);
+            }
+            if (decisionCache) {
+                decisionCache->invalidateUser(user.getId());
+            }
+            if (journal) {
+                std::string payload;
+                putInt(payload, user.getId());
+                switch (user.getKind()) {
+                    case UserKind::Student:
+                        putInt(payload, 0);
+                        putString(payload, static_cast<const Student&>(user).getGroup());
+                        break;
+                    case UserKind::Teacher:
+                        putInt(payload, 0);
+                        putString(payload, static_cast<const Teacher&>(user).getDepartment());
+                        break;
+                    case UserKind::Administrator:
+                        putInt(payload, static_cast<const Administrator&>(user).getAdminLevel());
+                        putString(payload, std::string());
+                        break;
+                    case UserKind::User:
+                        putInt(payload, 0);
+                        putString(payload, std::string());
+                        break;
+                }
+                appendToJournal(JournalRecordType::SetAttributes, payload);
+            }
+        }
+    }
+
+    // Compiled policy change: cached decisions of any user may be stale
+    template <typename Change>
+    void changePolicy(Change change) {
+        if (!permissions) {
+            setAccessPolicy(AccessPolicy());
+        }
+        change(*permissions);
+        if (decisionCache) {
+            decisionCache->clear();
+        }
+    }
+
+    void detachUsers() {
+        for (const auto& user : users) {
+            if (user->getObserver() == this) {
+                user->setObserver(nullptr);
+            }
+        }
+    }
+
+    // Arena of a new data set in arena mode, nullptr otherwise
+    std::shared_ptr<UserArena> newLoadArena() const {
+        return storage == UserStorage::Arena ? std::make_shared<UserArena>() : nullptr;
+    }
+
+    template <typename T, typename... Args>
+    static std::shared_ptr<T> makeUser(const std::shared_ptr<UserArena>& userArena, Args&&... args) {
+        if (userArena) {
+            return userArena->create<T>(std::forward<Args>(args)...);
+        }
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+
+    UserHandle indexUser(const std::shared_ptr<UserType>& user) {
+        // emplace keeps the first user with a given ID, as the linear search did
+        uint32_t slot = static_cast<uint32_t>(userLevels.size());
+        uint32_t number = static_cast<uint32_t>(usersByNumber.size());
+        if (usersById.emplace(user->getId(), UserEntry{user, slot, number}).second) {
+            userLevels.push_back(user->getAccessLevel());
+            if (permissions) {
+                userClasses.push_back(permissions->classify(*user));
+            }
+            if (decisionCache) {
+                decisionCache->invalidateUser(user->getId());
+            }
+        }
+        usersByNumber.push_back(user);
+        userNumbers.emplace(user.get(), number);
+        nameIndex.add(number, user->getName());
+        levelIndex.add(number, user->getAccessLevel());
+        user->setObserver(this);
+        return UserHandle{number};
+    }
+
+    void clearData() {
+        detachUsers();
+        users.clear();
+        resources.clear();
+        usersById.clear();
+        resourcesByName.clear();
+        for (auto& shard : resourcesBySymbol) {
+            shard.clear();
+        }
+        userLevels.clear();
+        resourceLevels.clear();
+        usersByNumber.clear();
+        userNumbers.clear();
+        nameIndex.clear();
+        levelIndex.clear();
+        userClasses.clear();
+        if (permissions) {
+            permissions->clear();
+        }
+        if (decisionCache) {
+            decisionCache->clear();
+        }
+    }
+
+    // Replaces all users and resources with fully built ones; loaders parse
+    // into temporaries first, so a failed load leaves the current data intact.
+    // In arena mode the loaded users come from loadedArena, which then also
+    // takes new users; the old arena goes away with the last pointer into it.
+    void replaceData(std::vector<std::shared_ptr<UserType>>&& loadedUsers,
+                     std::vector<std::shared_ptr<ResourceType>>&& loadedResources,
+                     std::shared_ptr<UserArena> loadedArena) {
+        clearData();
+        if (storage == UserStorage::Arena) {
+            arena = std::move(loadedArena);
+        }
+        users = std::move(loadedUsers);
+        usersById.reserve(users.size());
+        userLevels.reserve(users.size());
+        usersByNumber.reserve(users.size());
+        userNumbers.reserve(users.size());
+        for (const auto& user : users) {
+            indexUser(user);
+        }
+        resourcesByName.reserve(loadedResources.size());
+        resourceLevels.reserve(loadedResources.size());
+        for (auto& resource : loadedResources) {
+            addResource(std::move(resource));
+        }
+    }
+
+public:
+    explicit AccessControlSystem(UserStorage storage = UserStorage::Shared)
+        : storage(storage), arena(newLoadArena()) {}
+
+    // Users point back to the system, so it cannot be copied
+    AccessControlSystem(const AccessControlSystem&) = delete;
+    AccessControlSystem& operator=(const AccessControlSystem&) = delete;
+
+    ~AccessControlSystem() {
+        journal.reset();
+        detachUsers();
+    }
+
+    UserStorage userStorage() const { return storage; }
+
+    // New user of type T allocated as the storage mode says: from the
+    // system's arena or with make_shared. It still has to be added with addUser.
+    template <typename T, typename... Args>
+    std::shared_ptr<T> createUser(Args&&... args) {
+        return makeUser<T>(arena, std::forward<Args>(args)...);
+    }
+
+    // A user reports its changes to one system only, so a user that is
+    // already attached (to this or another system) is rejected
+    UserHandle addUser(std::shared_ptr<UserType> user) {
+        if (user->getObserver()) {
+            throw std::invalid_argument("Пользователь уже добавлен в систему");
+        }
+        users.push_back(user);
+        UserHandle handle = indexUser(user);
+        if (journal) {
+            journalUser(*user);
+        }
+        return handle;
+    }
+
+    // Handle of the user with the ID (the first one added); false if there is none
+    bool findUser(int id, UserHandle& handle) const {
+        auto it = usersById.find(id);
+        if (it == usersById.end()) {
+            return false;
+        }
+        handle = UserHandle{it->second.number};
+        return true;
+    }
+
+    const UserType& getUser(UserHandle handle) const { return *usersByNumber[handle.number]; }
+    UserType& getUser(UserHandle handle) { return *usersByNumber[handle.number]; }
+
+    // Approximate bytes of the users themselves (objects, reference counts
+    // and names, not the indexes): the arena, plus every user that was
+    // allocated elsewhere and added, counted as a make_shared block
+    size_t userStorageBytes() const {
+        size_t total = users.capacity() * sizeof(std::shared_ptr<UserType>);
+        if (arena) {
+            total += arena->memoryUsage();
+        }
+        for (const auto& user : usersByNumber) {
+            if (!arena || !arena->contains(*user)) {
+                total += sharedUserBytes(*user);
+            }
+        }
+        return total;
+    }
+
+    void addResource(std::shared_ptr<ResourceType> resource) {
+        resources.push_back(resource);
+        if (permissions) {
+            permissions->addResource(*resource);
+        }
+        if (resourcesByName.emplace(resource->getName(), static_cast<int>(resources.size() - 1)).second) {
+            const Symbol symbol = resource->getNameSymbol();
+            std::vector<int32_t>& shard = resourcesBySymbol[SymbolTable::shardOf(symbol)];
+            const uint32_t index = SymbolTable::indexInShard(symbol);
+            if (index >= shard.size()) {
+                shard.resize(index + 1, -1);
+            }
+            shard[index] = static_cast<int32_t>(resources.size() - 1);
+            resourceLevels.push_back(resource->getRequiredAccessLevel());
+            if (decisionCache) {
+                decisionCache->invalidateResource(static_cast<int>(resources.size() - 1));
+            }
+        } else {
+            // Duplicate names are never looked up, but keep IDs equal to positions
+            resourceLevels.push_back(resourceLevels[resourcesByName[resource->getName()]]);
+        }
+        // Journaled after the mutation, as users are: the append may compact
+        // the journal, and the snapshot it writes must contain the resource
+        if (journal) {
+            std::string payload;
+            putInt(payload, resource->getRequiredAccessLevel());
+            putString(payload, resource->getName());
+            appendToJournal(JournalRecordType::AddResource, payload);
+        }
+    }
+
+    const std::vector<std::shared_ptr<UserType>>& getUsers() const { return users; }
+    const std::vector<std::shared_ptr<ResourceType>>& getResources() const { return resources; }
+
+    // Resource ID for batch checks, or -1 if there is no such resource
+    int findResourceId(const std::string& resourceName) const {
+        auto it = resourcesByName.find(resourceName);
+        return it != resourcesByName.end() ? it->second : -1;
+    }
+
+    // Same by interned name: an array lookup instead of hashing the string
+    int findResourceId(Symbol resourceName) const {
+        const std::vector<int32_t>& shard = resourcesBySymbol[SymbolTable::shardOf(resourceName)];
+        const uint32_t index = SymbolTable::indexInShard(resourceName);
+        return index < shard.size() ? shard[index] : -1;
+    }
+
+    void displayUsers() const {
+        for (const auto& user : users) {
+            user->displayInfo();
+        }
+    }
+
+    void displayResources() const {
+        for (const auto& resource : resources) {
+            resource->displayInfo();
+        }
+    }
+
+    // Put a bounded decision cache in front of access checks. It is kept
+    // exact: entries are dropped when a user's access level changes, when a
+    // user or resource is added and when the data set is reloaded.
+    void enableDecisionCache(size_t capacity) {
+        decisionCache.reset(new AccessDecisionCache(capacity));
+    }
+
+    void disableDecisionCache() {
+        decisionCache.reset();
+    }
+
+    // Counters of the decision cache; all zero when it is disabled
+    AccessCacheStats decisionCacheStats() const {
+        return decisionCache ? decisionCache->stats() : AccessCacheStats();
+    }
+
+    // Evaluate access through an AccessPolicy compiled into a PermissionMatrix
+    // instead of comparing access levels only. The policy stays in effect
+    // across reloads; its rules can be changed incrementally below.
+    void setAccessPolicy(const AccessPolicy& policy) {
+        permissions.reset(new PermissionMatrix(policy));
+        userClasses.assign(userLevels.size(), 0);
+        for (const auto& entry : usersById) {
+            userClasses[entry.second.slot] = permissions->classify(*entry.second.user);
+        }
+        for (const auto& resource : resources) {
+            permissions->addResource(*resource);
+        }
+        if (decisionCache) {
+            decisionCache->clear();
+        }
+        journalAccessPolicy(permissions.get());
+    }
+
+    void clearAccessPolicy() {
+        permissions.reset();
+        userClasses.clear();
+        if (decisionCache) {
+            decisionCache->clear();
+        }
+        journalAccessPolicy(nullptr);
+    }
+
+    // Compiled policy, or nullptr when access is checked by level only
+    const PermissionMatrix* accessPolicy() const { return permissions.get(); }
+
+    // Rule changes are journaled once they are applied
+    void grantGroupAccess(const std::string& group, const std::string& resourceName) {
+        changePolicy([&](PermissionMatrix& matrix) { matrix.grantGroup(group, resourceName); });
+        journalPolicyRule(PolicyRuleKind::GroupGrant, true, group, resourceName, 0);
+    }
+
+    void revokeGroupAccess(const std::string& group, const std::string& resourceName) {
+        changePolicy([&](PermissionMatrix& matrix) { matrix.revokeGroup(group, resourceName); });
+        journalPolicyRule(PolicyRuleKind::GroupGrant, false, group, resourceName, 0);
+    }
+
+    void grantDepartmentAccess(const std::string& department, const std::string& resourceName) {
+        changePolicy([&](PermissionMatrix& matrix) { matrix.grantDepartment(department, resourceName); });
+        journalPolicyRule(PolicyRuleKind::DepartmentGrant, true, department, resourceName, 0);
+    }
+
+    void revokeDepartmentAccess(const std::string& department, const std::string& resourceName) {
+        changePolicy([&](PermissionMatrix& matrix) { matrix.revokeDepartment(department, resourceName); });
+        journalPolicyRule(PolicyRuleKind::DepartmentGrant, false, department, resourceName, 0);
+    }
+
+    void setAdminOverride(const std::string& resourceName, int minAdminLevel) {
+        changePolicy([&](PermissionMatrix& matrix) { matrix.setAdminOverride(resourceName, minAdminLevel); });
+        journalPolicyRule(PolicyRuleKind::AdminOverride, true, std::string(), resourceName, minAdminLevel);
+    }
+
+    void clearAdminOverride(const std::string& resourceName) {
+        changePolicy([&](PermissionMatrix& matrix) { matrix.clearAdminOverride(resourceName); });
+        journalPolicyRule(PolicyRuleKind::AdminOverride, false, std::string(), resourceName, 0);
+    }
+
+    // Access check by resource ID (see findResourceId)
+    bool checkUserAccessToResource(int userId, int resourceId) const {
+        bool granted;
+        if (decisionCache && decisionCache->lookup(userId, resourceId, granted)) {
+            return granted;
+        }
+        auto userIt = usersById.find(userId);
+        if (userIt == usersById.end()) {
+            throw std::runtime_error("Пользователь не найден");
+        }
+        if (resourceId < 0 || resourceId >= static_cast<int>(resources.size())) {
+            throw std::runtime_error("Ресурс не найден");
+        }
+        granted = permissions ? permissions->allowed(userClasses[userIt->second.slot], resourceId)
+                              : resources[resourceId]->checkAccess(*userIt->second.user);
+        if (decisionCache) {
+            decisionCache->insert(userId, resourceId, granted);
+        }
+        return granted;
+    }
+
+    bool checkUserAccessToResource(int userId, const std::string& resourceName) const {
+        if (decisionCache) {
+            int resourceId = findResourceId(resourceName);
+            if (resourceId >= 0) {
+                return checkUserAccessToResource(userId, resourceId);
+            }
+        }
+        auto userIt = usersById.find(userId);
+        if (userIt == usersById.end()) {
+            throw std::runtime_error("Пользователь не найден");
+        }
+
+        auto resourceIt = resourcesByName.find(resourceName);
+        if (resourceIt == resourcesByName.end()) {
+            throw std::runtime_error("Ресурс не найден");
+        }
+
+        if (permissions) {
+            return permissions->allowed(userClasses[userIt->second.slot], resourceIt->second);
+        }
+        return resources[resourceIt->second]->checkAccess(*userIt->second.user);
+    }
+
+    // Access check by interned resource name, without hashing the string
+    bool checkUserAccessToResource(int userId, Symbol resourceName) const {
+        int resourceId = findResourceId(resourceName);
+        if (resourceId < 0) {
+            throw std::runtime_error("Ресурс не найден");
+        }
+        return checkUserAccessToResource(userId, resourceId);
+    }
+
+    // Check count (userIds[i], resourceIds[i]) pairs at once. Pairs are resolved
+    // in blocks of 64 into packed level arrays, which are then compared in a
+    // branch-free loop the compiler vectorizes. Misses are reported per pair.
+    // With an access policy every pair is a bit test in the permission matrix.
+    void checkAccessBatch(const int* userIds, const int* resourceIds, size_t count,
+                          AccessBatchResult& result) const {
+        const size_t words = (count + 63) / 64;
+        result.size = count;
+        result.granted.assign(words, 0);
+        result.missing.assign(words, 0);
+
+        if (permissions) {
+            const int resourceCount = static_cast<int>(resources.size());
+            for (size_t i = 0; i < count; ++i) {
+                auto userIt = usersById.find(userIds[i]);
+                int resourceId = resourceIds[i];
+                if (userIt == usersById.end() || resourceId < 0 || resourceId >= resourceCount) {
+                    result.missing[i / 64] |= uint64_t(1) << (i % 64);
+                } else if (permissions->allowed(userClasses[userIt->second.slot], resourceId)) {
+                    result.granted[i / 64] |= uint64_t(1) << (i % 64);
+                }
+            }
+            return;
+        }
+
+        alignas(64) int32_t have[64];
+        alignas(64) int32_t need[64];
+        alignas(64) uint8_t ok[64];
+        const int resourceCount = static_cast<int>(resourceLevels.size());
+
+        for (size_t word = 0; word < words; ++word) {
+            const size_t base = word * 64;
+            const size_t n = std::min<size_t>(64, count - base);
+            uint64_t missing = 0;
+
+            for (size_t j = 0; j < n; ++j) {
+                auto userIt = usersById.find(userIds[base + j]);
+                int resourceId = resourceIds[base + j];
+                if (userIt == usersById.end() || resourceId < 0 || resourceId >= resourceCount) {
+                    have[j] = -1;
+                    need[j] = 0;
+                    missing |= uint64_t(1) << j;
+                } else {
+                    have[j] = userLevels[userIt->second.slot];
+                    need[j] = resourceLevels[resourceId];
+                }
+            }
+            for (size_t j = n; j < 64; ++j) {
+                have[j] = -1;
+                need[j] = 0;
+            }
+
+            for (size_t j = 0; j < 64; ++j) {
+                ok[j] = have[j] >= need[j];
+            }
+            uint64_t granted = 0;
+            for (size_t j = 0; j < 64; ++j) {
+                granted |= uint64_t(ok[j]) << j;
+            }
+
+            result.granted[word] = granted;
+            result.missing[word] = missing;
+        }
+    }
+
+    // Search users by name
+    std::vector<std::shared_ptr<UserType>> searchUsersByName(const std::string& name) const {
+        std::vector<std::shared_ptr<UserType>> result;
+        UserSearchResult<UserType> found = nameIndex.findExact(name);
+        result.reserve(found.size());
+        for (size_t i = 0; i < found.size(); ++i) {
+            result.push_back(found.pointer(i));
+        }
+        return result;
+    }
+
+    // Indexed name search without copying pointers: exact full name, or users
+    // whose name contains all tokens of the query (as whole tokens or prefixes)
+    UserSearchResult<UserType> findUsersByName(const std::string& name) const {
+        return nameIndex.findExact(name);
+    }
+
+    UserSearchResult<UserType> findUsersByTokens(const std::string& query, bool prefix = true) const {
+        return nameIndex.findTokens(query, prefix);
+    }
+
+    // Search users by ID
+    std::shared_ptr<UserType> searchUserById(int id) const {
+        auto it = usersById.find(id);
+        if (it != usersById.end()) {
+            return it->second.user;
+        }
+        return nullptr;
+    }
+
+    // Sort users by access level ascending. The order is read from the level
+    // index in O(n); users with equal levels keep their insertion order.
+    void sortUsersByAccessLevel() {
+        size_t i = 0;
+        levelIndex.forEach([this, &i](uint32_t number) { users[i++] = usersByNumber[number]; });
+    }
+
+    // Users whose access level is at least level, ordered by level
+    UserSearchResult<UserType> usersWithLevelAtLeast(int level) const {
+        AccessLevelCursor cursor;
+        return UserSearchResult<UserType>(usersByNumber, levelIndex.page(level, cursor, usersByNumber.size()));
+    }
+
+    size_t countUsersWithLevelAtLeast(int level) const {
+        return levelIndex.countAtLeast(level);
+    }
+
+    // Users who pass the resource's access check, ordered by level
+    UserSearchResult<UserType> usersWhoCanAccess(const std::string& resourceName) const {
+        int resourceId = findResourceId(resourceName);
+        if (resourceId < 0) {
+            throw std::runtime_error("Ресурс не найден");
+        }
+        if (!permissions) {
+            return usersWithLevelAtLeast(resourceLevels[resourceId]);
+        }
+        // Grants do not follow levels, so every user is tested against the matrix
+        std::vector<uint32_t> found;
+        levelIndex.forEach([&](uint32_t number) {
+            const UserType& user = *usersByNumber[number];
+            auto it = usersById.find(user.getId());
+            bool granted = it != usersById.end() && it->second.user.get() == &user
+                ? permissions->allowed(userClasses[it->second.slot], resourceId)
+                : permissions->getPolicy().allows(user, *resources[resourceId]);
+            if (granted) {
+                found.push_back(number);
+            }
+        });
+        return UserSearchResult<UserType>(usersByNumber, std::move(found));
+    }
+
+    // Next page of at most pageSize users with level >= level; start with a
+    // default cursor and call again until cursor.finished is set
+    UserSearchResult<UserType> usersWithLevelAtLeastPage(int level, AccessLevelCursor& cursor, size_t pageSize) const {
+        return UserSearchResult<UserType>(usersByNumber, levelIndex.page(level, cursor, pageSize));
+    }
+
+    // Save users and resources to a binary snapshot (see SnapshotHeader)
+    void saveSnapshot(const std::string& filename) const {
+        SnapshotStringBlock strings;
+        std::vector<SnapshotUserRecord> userRecords(users.size());
+        for (size_t i = 0; i < users.size(); ++i) {
+            const UserType& user = *users[i];
+            SnapshotUserRecord& record = userRecords[i];
+            std::memset(&record, 0, sizeof(record));
+            record.id = user.getId();
+            record.accessLevel = user.getAccessLevel();
+            record.nameOffset = strings.add(std::string(user.getName()));
+            record.kind = static_cast<uint8_t>(user.getKind());
+            switch (user.getKind()) {
+                case UserKind::Student:
+                    record.extraOffset = strings.add(static_cast<const Student&>(user).getGroupSymbol());
+                    break;
+                case UserKind::Teacher:
+                    record.extraOffset = strings.add(static_cast<const Teacher&>(user).getDepartmentSymbol());
+                    break;
+                case UserKind::Administrator:
+                    record.adminLevel = static_cast<const Administrator&>(user).getAdminLevel();
+                    break;
+                case UserKind::User:
+                    break;
+            }
+        }
+        std::vector<uint32_t> userIdIndex(users.size());
+        for (size_t i = 0; i < userIdIndex.size(); ++i) {
+            userIdIndex[i] = static_cast<uint32_t>(i);
+        }
+        std::stable_sort(userIdIndex.begin(), userIdIndex.end(),
+            [&userRecords](uint32_t a, uint32_t b) { return userRecords[a].id < userRecords[b].id; });
+
+        std::vector<SnapshotResourceRecord> resourceRecords(resources.size());
+        for (size_t i = 0; i < resources.size(); ++i) {
+            resourceRecords[i].nameOffset = strings.add(resources[i]->getNameSymbol());
+            resourceRecords[i].requiredAccessLevel = resources[i]->getRequiredAccessLevel();
+        }
+        std::vector<uint32_t> resourceNameIndex(resources.size());
+        for (size_t i = 0; i < resourceNameIndex.size(); ++i) {
+            resourceNameIndex[i] = static_cast<uint32_t>(i);
+        }
+        std::stable_sort(resourceNameIndex.begin(), resourceNameIndex.end(),
+            [this](uint32_t a, uint32_t b) { return resources[a]->getName() < resources[b]->getName(); });
+
+        std::vector<SnapshotPolicyRecord> policyRecords;
+        if (permissions) {
+            permissions->getPolicy().forEachRule(
+                [&](PolicyRuleKind kind, Symbol attribute, Symbol resourceName, int minAdminLevel) {
+                    SnapshotPolicyRecord record;
+                    std::memset(&record, 0, sizeof(record));
+                    record.kind = static_cast<uint8_t>(kind);
+                    record.attributeOffset = kind == PolicyRuleKind::AdminOverride ? 0 : strings.add(attribute);
+                    record.resourceOffset = strings.add(resourceName);
+                    record.minAdminLevel = minAdminLevel;
+                    policyRecords.push_back(record);
+                });
+        }
+
+        SnapshotHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.version = SNAPSHOT_VERSION;
+        header.userCount = static_cast<uint32_t>(userRecords.size());
+        header.resourceCount = static_cast<uint32_t>(resourceRecords.size());
+        header.usersOffset = sizeof(SnapshotHeader);
+        header.userIdIndexOffset = header.usersOffset + userRecords.size() * sizeof(SnapshotUserRecord);
+        header.resourcesOffset = header.userIdIndexOffset + userIdIndex.size() * sizeof(uint32_t);
+        header.resourceNameIndexOffset = header.resourcesOffset + resourceRecords.size() * sizeof(SnapshotResourceRecord);
+        header.policyOffset = header.resourceNameIndexOffset + resourceNameIndex.size() * sizeof(uint32_t);
+        header.policyRuleCount = static_cast<uint32_t>(policyRecords.size());
+        header.policyEnabled = permissions ? 1 : 0;
+        header.stringsOffset = header.policyOffset + policyRecords.size() * sizeof(SnapshotPolicyRecord);
+        header.stringsSize = strings.bytes().size();
+        header.fileSize = header.stringsOffset + header.stringsSize;
+        header.journalSequence = journal ? journal->lastSequence() : 0;
+
+        // Written to a temporary file and renamed, so a crash never leaves a half-written snapshot
+        const std::string tempFilename = filename + ".tmp";
+        std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Не удалось открыть файл снимка для записи");
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(userRecords.data()), userRecords.size() * sizeof(SnapshotUserRecord));
+        file.write(reinterpret_cast<const char*>(userIdIndex.data()), userIdIndex.size() * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(resourceRecords.data()), resourceRecords.size() * sizeof(SnapshotResourceRecord));
+        file.write(reinterpret_cast<const char*>(resourceNameIndex.data()), resourceNameIndex.size() * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(policyRecords.data()), policyRecords.size() * sizeof(SnapshotPolicyRecord));
+        file.write(strings.bytes().data(), strings.bytes().size());
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Ошибка записи файла снимка");
+        }
+        syncFile(tempFilename);
+        std::filesystem::rename(tempFilename, filename);
+        syncParentDirectory(filename);
+    }
+
+    // Recover from the last snapshot plus the journal, then journal every
+    // further mutation. Records already contained in the snapshot are skipped.
+    JournalStats openJournal(const std::string& snapshotFile, const std::string& journalFile,
+                             const JournalOptions& options = JournalOptions()) {
+        auto start = std::chrono::steady_clock::now();
+        journal.reset();
+        uint64_t lastSequence = 0;
+        if (std::filesystem::exists(snapshotFile)) {
+            loadSnapshot(snapshotFile);
+            lastSequence = MappedSnapshot(snapshotFile).journalSequence();
+        } else {
+            clearData();
+        }
+
+        JournalStats stats;
+        uint64_t inFile = MutationJournal::replay(journalFile, [&](const MutationJournal::Record& record) {
+            if (record.sequence > lastSequence) {
+                applyJournalRecord(record);
+                lastSequence = record.sequence;
+                ++stats.replayedRecords;
+            }
+        });
+        journal.reset(new MutationJournal(journalFile, lastSequence, inFile, options));
+        journalSnapshotFile = snapshotFile;
+        stats.recoveryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    void closeJournal() {
+        journal.reset();
+    }
+
+    void commitJournal() {
+        if (journal) {
+            journal->commit();
+        }
+    }
+
+    // Write a full snapshot that covers the journal, then empty the journal.
+    // A crash in between is harmless: the snapshot records the last sequence.
+    void compactJournal() {
+        if (!journal) {
+            return;
+        }
+        journal->commit();
+        saveSnapshot(journalSnapshotFile);
+        journal->truncate();
+    }
+
+    // Replace users and resources with the contents of a binary snapshot
+    // The snapshot is validated when it is opened and all objects are built
+    // before the current data is replaced, so a bad file leaves it intact
+    void loadSnapshot(const std::string& filename) {
+        JournalSuspension suspension(*this);
+        MappedSnapshot snapshot(filename);
+
+        // Each distinct string of the block is interned once
+        std::unordered_map<uint32_t, Symbol> symbols;
+        auto symbolAt = [&](uint32_t offset) {
+            auto it = symbols.find(offset);
+            if (it == symbols.end()) {
+                it = symbols.emplace(offset, SymbolTable::global().intern(snapshot.string(offset))).first;
+            }
+            return it->second;
+        };
+
+        std::shared_ptr<UserArena> loadArena = newLoadArena();
+        std::vector<std::shared_ptr<UserType>> loadedUsers;
+        loadedUsers.reserve(snapshot.userCount());
+        for (uint32_t i = 0; i < snapshot.userCount(); ++i) {
+            const SnapshotUserRecord& record = snapshot.userRecord(i);
+            std::string name(snapshot.string(record.nameOffset));
+            switch (static_cast<UserKind>(record.kind)) {
+                case UserKind::Student:
+                    loadedUsers.push_back(makeUser<Student>(loadArena, name, record.id, record.accessLevel, symbolAt(record.extraOffset)));
+                    break;
+                case UserKind::Teacher:
+                    loadedUsers.push_back(makeUser<Teacher>(loadArena, name, record.id, record.accessLevel, symbolAt(record.extraOffset)));
+                    break;
+                case UserKind::Administrator:
+                    loadedUsers.push_back(makeUser<Administrator>(loadArena, name, record.id, record.accessLevel, record.adminLevel));
+                    break;
+                case UserKind::User:
+                    loadedUsers.push_back(makeUser<User>(loadArena, name, record.id, record.accessLevel));
+                    break;
+            }
+        }
+        std::vector<std::shared_ptr<ResourceType>> loadedResources;
+        loadedResources.reserve(snapshot.resourceCount());
+        for (uint32_t i = 0; i < snapshot.resourceCount(); ++i) {
+            const SnapshotResourceRecord& record = snapshot.resourceRecord(i);
+            loadedResources.push_back(std::make_shared<Resource>(symbolAt(record.nameOffset), record.requiredAccessLevel));
+        }
+        AccessPolicy policy;
+        for (uint32_t i = 0; i < snapshot.policyRuleCount(); ++i) {
+            const SnapshotPolicyRecord& record = snapshot.policyRecord(i);
+            const std::string& resourceName = symbolAt(record.resourceOffset).str();
+            switch (static_cast<PolicyRuleKind>(record.kind)) {
+                case PolicyRuleKind::GroupGrant:
+                    policy.grantGroup(symbolAt(record.attributeOffset).str(), resourceName);
+                    break;
+                case PolicyRuleKind::DepartmentGrant:
+                    policy.grantDepartment(symbolAt(record.attributeOffset).str(), resourceName);
+                    break;
+                case PolicyRuleKind::AdminOverride:
+                    policy.setAdminOverride(resourceName, record.minAdminLevel);
+                    break;
+            }
+        }
+        replaceData(std::move(loadedUsers), std::move(loadedResources), std::move(loadArena));
+        // Snapshots that record the policy restore it; older ones keep the current policy
+        if (snapshot.policyEnabled()) {
+            setAccessPolicy(policy);
+        } else if (snapshot.hasPolicy()) {
+            clearAccessPolicy();
+        }
+    }
+
+    // Save users and resources to files
+    void saveToFile(const std::string& usersFile, const std::string& resourcesFile) const {
+        std::ofstream uFile(usersFile);
+        if (!uFile) {
+            throw std::runtime_error("Не удалось открыть файл пользователей для записи");
+        }
+        for (const auto& user : users) {
+            // Save user type info for loading
+            if (dynamic_cast<Student*>(user.get())) {
+                uFile << "Student ";
+                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << " ";
+                uFile << static_cast<Student*>(user.get())->getGroup() << std::endl;
+            } else if (dynamic_cast<Teacher*>(user.get())) {
+                uFile << "Teacher ";
+                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << " ";
+                uFile << static_cast<Teacher*>(user.get())->getDepartment() << std::endl;
+            } else if (dynamic_cast<Administrator*>(user.get())) {
+                uFile << "Administrator ";
+                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << " ";
+                uFile << static_cast<Administrator*>(user.get())->getAdminLevel() << std::endl;
+            } else {
+                uFile << "User ";
+                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << std::endl;
+            }
+        }
+        uFile.close();
+
+        std::ofstream rFile(resourcesFile);
+        if (!rFile) {
+            throw std::runtime_error("Не удалось открыть файл ресурсов для записи");
+        }
+        for (const auto& resource : resources) {
+            rFile << resource->getName() << " " << resource->getRequiredAccessLevel() << std::endl;
+        }
+        rFile.close();
+    }
+
+    // Load users and resources from files. The current data is kept if the
+    // files cannot be loaded.
+    void loadFromFile(const std::string& usersFile, const std::string& resourcesFile) {
+        JournalSuspension suspension(*this);
+        std::shared_ptr<UserArena> loadArena = newLoadArena();
+        std::vector<std::shared_ptr<UserType>> loadedUsers;
+        std::vector<std::shared_ptr<ResourceType>> loadedResources;
+
+        std::ifstream uFile(usersFile);
+        if (!uFile) {
+            throw std::runtime_error("Не удалось открыть файл пользователей для чтения");
+        }
+        std::string userType;
+        while (uFile >> userType) {
+            if (userType == "Student") {
+                std::string name, group;
+                int id, accessLevel;
+                uFile >> name >> id >> accessLevel >> group;
+                loadedUsers.push_back(makeUser<Student>(loadArena, name, id, accessLevel, group));
+            } else if (userType == "Teacher") {
+                std::string name, department;
+                int id, accessLevel;
+                uFile >> name >> id >> accessLevel >> department;
+                loadedUsers.push_back(makeUser<Teacher>(loadArena, name, id, accessLevel, department));
+            } else if (userType == "Administrator") {
+                std::string name;
+                int id, accessLevel, adminLevel;
+                uFile >> name >> id >> accessLevel >> adminLevel;
+                loadedUsers.push_back(makeUser<Administrator>(loadArena, name, id, accessLevel, adminLevel));
+            } else if (userType == "User") {
+                std::string name;
+                int id, accessLevel;
+                uFile >> name >> id >> accessLevel;
+                loadedUsers.push_back(makeUser<User>(loadArena, name, id, accessLevel));
+            } else {
+                // Unknown user type, skip line
+                std::string skipLine;
+                std::getline(uFile, skipLine);
+            }
+        }
+        uFile.close();
+
+        std::ifstream rFile(resourcesFile);
+        if (!rFile) {
+            throw std::runtime_error("Не удалось открыть файл ресурсов для чтения");
+        }
+        std::string resourceName;
+        int accessLevel;
+        while (rFile >> resourceName >> accessLevel) {
+            loadedResources.push_back(std::make_shared<Resource>(resourceName, accessLevel));
+        }
+        rFile.close();
+        replaceData(std::move(loadedUsers), std::move(loadedResources), std::move(loadArena));
+    }
+
+    // Same format as loadFromFile, for very large files: each file is read
+    // at once, parsed by newline-aligned chunks on a pool of threads with
+    // std::from_chars, and merged into presized vectors before the indexes
+    // are built. The current data is kept if the files cannot be loaded.
+    LoadTimings loadFromFileParallel(const std::string& usersFile, const std::string& resourcesFile,
+                                     unsigned threads = std::thread::hardware_concurrency()) {
+        JournalSuspension suspension(*this);
+        using Clock = std::chrono::steady_clock;
+        auto elapsedMs = [](Clock::time_point from) {
+            return std::chrono::duration<double, std::milli>(Clock::now() - from).count();
+        };
+        LoadTimings timings;
+        timings.threads = std::max(1u, threads);
+
+        auto phase = Clock::now();
+        std::string usersText = readWholeFile(usersFile, "Не удалось открыть файл пользователей для чтения");
+        std::string resourcesText = readWholeFile(resourcesFile, "Не удалось открыть файл ресурсов для чтения");
+        timings.readMs = elapsedMs(phase);
+
+        phase = Clock::now();
+        std::shared_ptr<UserArena> loadArena = newLoadArena();
+        auto userChunks = parseLinesParallel<std::shared_ptr<UserType>>(usersText, timings.threads,
+            [&loadArena](const char* pos, const char* end, std::vector<std::shared_ptr<UserType>>& out) {
+                std::string_view fields[5];
+                size_t count = splitFields(pos, end, fields, 5);
+                if (count == 0) {
+                    return;
+                }
+                if (fields[0] == "Student" && count == 5) {
+                    out.push_back(makeUser<Student>(loadArena, std::string(fields[1]), parseIntField(fields[2]),
+                                                    parseIntField(fields[3]), std::string(fields[4])));
+                } else if (fields[0] == "Teacher" && count == 5) {
+                    out.push_back(makeUser<Teacher>(loadArena, std::string(fields[1]), parseIntField(fields[2]),
+                                                    parseIntField(fields[3]), std::string(fields[4])));
+                } else if (fields[0] == "Administrator" && count == 5) {
+                    out.push_back(makeUser<Administrator>(loadArena, std::string(fields[1]), parseIntField(fields[2]),
+                                                          parseIntField(fields[3]), parseIntField(fields[4])));
+                } else if (fields[0] == "User" && count == 4) {
+                    out.push_back(makeUser<User>(loadArena, std::string(fields[1]), parseIntField(fields[2]),
+                                                 parseIntField(fields[3])));
+                } else if (fields[0] == "Student" || fields[0] == "Teacher" ||
+                           fields[0] == "Administrator" || fields[0] == "User") {
+                    throw std::runtime_error("Неверная строка в файле пользователей: " + std::string(pos, end));
+                }
+                // Unknown user type, skip line
+            });
+        auto resourceChunks = parseLinesParallel<std::shared_ptr<ResourceType>>(resourcesText, timings.threads,
+            [](const char* pos, const char* end, std::vector<std::shared_ptr<ResourceType>>& out) {
+                std::string_view fields[2];
+                size_t count = splitFields(pos, end, fields, 2);
+                if (count == 0) {
+                    return;
+                }
+                if (count != 2) {
+                    throw std::runtime_error("Неверная строка в файле ресурсов: " + std::string(pos, end));
+                }
+                out.push_back(std::make_shared<Resource>(std::string(fields[0]), parseIntField(fields[1])));
+            });
+        timings.parseMs = elapsedMs(phase);
+
+        phase = Clock::now();
+        std::vector<size_t> offsets(userChunks.size() + 1, 0);
+        for (size_t i = 0; i < userChunks.size(); ++i) {
+            offsets[i + 1] = offsets[i] + userChunks[i].size();
+        }
+        std::vector<std::shared_ptr<UserType>> loadedUsers(offsets.back());
+        {
+            std::atomic<size_t> nextChunk{0};
+            auto mover = [&]() {
+                size_t chunk;
+                while ((chunk = nextChunk.fetch_add(1)) < userChunks.size()) {
+                    std::move(userChunks[chunk].begin(), userChunks[chunk].end(), loadedUsers.begin() + offsets[chunk]);
+                }
+            };
+            std::vector<std::thread> pool;
+            for (unsigned i = 1; i < timings.threads; ++i) {
+                pool.emplace_back(mover);
+            }
+            mover();
+            for (auto& thread : pool) {
+                thread.join();
+            }
+        }
+        std::vector<std::shared_ptr<ResourceType>> loadedResources;
+        for (auto& chunk : resourceChunks) {
+            loadedResources.insert(loadedResources.end(),
+                                   std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.end()));
+        }
+        timings.mergeMs = elapsedMs(phase);
+
+        phase = Clock::now();
+        replaceData(std::move(loadedUsers), std::move(loadedResources), std::move(loadArena));
+        timings.indexMs = elapsedMs(phase);
+        return timings;
+    }
+};
+
+// Index of the calling thread among live threads, used to give every
+// reader thread its own hazard pointer slot. Slots of finished threads are reused.
+const unsigned MAX_READER_THREADS = 256;
+
+inline unsigned readerThreadSlot() {
+    static std::mutex slotsMutex;
+    static std::vector<unsigned> freeSlots;
+    static unsigned nextSlot = 0;
+
+    struct SlotHolder {
+        unsigned slot;
+        SlotHolder() {
+            std::lock_guard<std::mutex> lock(slotsMutex);
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            } else if (nextSlot < MAX_READER_THREADS) {
+                slot = nextSlot++;
+            } else {
+                throw std::runtime_error("Слишком много потоков-читателей");
+            }
+        }
+        ~SlotHolder() {
+            std::lock_guard<std::mutex> lock(slotsMutex);
+            freeSlots.push_back(slot);
+        }
+    };
+    thread_local SlotHolder holder;
+    return holder.slot;
+}
+
+// Concurrent variant of AccessControlSystem. Readers never lock: they take
+// the current immutable version through an atomic pointer and protect it
+// with a hazard pointer. Writers are serialized, build a new version and
+// publish it; old versions are deleted once no reader's hazard pointer
+// refers to them. Users are split into shards so a write copies only the
+// shard it changes, while unchanged shards are shared between versions.
+template <typename UserType, typename ResourceType>
+class ConcurrentAccessControlSystem {
+private:
+    static const size_t USER_SHARDS = 1024;
+
+    using UserShard = std::unordered_map<int, std::shared_ptr<const UserType>>;
+
+    struct Version {
+        std::vector<std::shared_ptr<const UserShard>> userShards;
+        std::unordered_map<std::string, std::shared_ptr<const ResourceType>> resourcesByName;
+        size_t userCount = 0;
+    };
+
+    struct alignas(64) HazardSlot {
+        std::atomic<const Version*> pointer{nullptr};
+    };
+
+    std::atomic<const Version*> current;
+    HazardSlot hazards[MAX_READER_THREADS];
+    std::mutex writerMutex;
+    std::vector<const Version*> retired;
+
+    static size_t shardOf(int id) {
+        return static_cast<size_t>(static_cast<uint32_t>(id)) % USER_SHARDS;
+    }
+
+    // Publish a new version and delete the retired ones no reader uses anymore.
+    // Must be called with writerMutex held.
+    void publish(const Version* next) {
+        retired.push_back(current.exchange(next));
+
+        std::vector<const Version*> inUse;
+        for (const auto& hazard : hazards) {
+            if (const Version* version = hazard.pointer.load()) {
+                inUse.push_back(version);
+            }
+        }
+        auto stillUsed = std::partition(retired.begin(), retired.end(), [&inUse](const Version* version) {
+            return std::find(inUse.begin(), inUse.end(), version) != inUse.end();
+        });
+        for (auto it = stillUsed; it != retired.end(); ++it) {
+            delete *it;
+        }
+        retired.erase(stillUsed, retired.end());
+    }
+
+    void insertUser(Version& version, std::shared_ptr<const UserType> user) {
+        size_t shard = shardOf(user->getId());
+        auto copy = std::make_shared<UserShard>(*version.userShards[shard]);
+        if (copy->emplace(user->getId(), std::move(user)).second) {
+            ++version.userCount;
+        }
+        version.userShards[shard] = std::move(copy);
+    }
+
+public:
+    // A consistent read-only view of the system; valid while it lives.
+    // Views are meant to be short-lived and are not nested within one thread.
+    class ReadView {
+    private:
+        const Version* version;
+        HazardSlot* slot;
+
+    public:
+        ReadView(const Version* version, HazardSlot* slot) : version(version), slot(slot) {}
+        ReadView(const ReadView&) = delete;
+        ReadView& operator=(const ReadView&) = delete;
+        ~ReadView() { slot->pointer.store(nullptr, std::memory_order_release); }
+
+        size_t userCount() const { return version->userCount; }
+
+        const UserType* findUser(int id) const {
+            const UserShard& shard = *version->userShards[shardOf(id)];
+            auto it = shard.find(id);
+            return it != shard.end() ? it->second.get() : nullptr;
+        }
+
+        const ResourceType* findResource(const std::string& name) const {
+            auto it = version->resourcesByName.find(name);
+            return it != version->resourcesByName.end() ? it->second.get() : nullptr;
+        }
+
+        bool checkUserAccessToResource(int userId, const std::string& resourceName) const {
+            const UserType* user = findUser(userId);
+            if (!user) {
+                throw std::runtime_error("Пользователь не найден");
+            }
+            const ResourceType* resource = findResource(resourceName);
+            if (!resource) {
+                throw std::runtime_error("Ресурс не найден");
+            }
+            return resource->checkAccess(*user);
+        }
+    };
+
+    ConcurrentAccessControlSystem() {
+        auto initial = new Version;
+        for (size_t i = 0; i < USER_SHARDS; ++i) {
+            initial->userShards.push_back(std::make_shared<const UserShard>());
+        }
+        current.store(initial);
+    }
+
+    // No reader may be active when the system is destroyed
+    ~ConcurrentAccessControlSystem() {
+        delete current.load();
+        for (const Version* version : retired) {
+            delete version;
+        }
+    }
+
+    ConcurrentAccessControlSystem(const ConcurrentAccessControlSystem&) = delete;
+    ConcurrentAccessControlSystem& operator=(const ConcurrentAccessControlSystem&) = delete;
+
+    ReadView read() {
+        HazardSlot* slot = &hazards[readerThreadSlot()];
+        const Version* version = current.load();
+        for (;;) {
+            slot->pointer.store(version);
+            const Version* recheck = current.load();
+            if (recheck == version) {
+                break;
+            }
+            version = recheck;
+        }
+        return ReadView(version, slot);
+    }
+
+    bool checkUserAccessToResource(int userId, const std::string& resourceName) {
+        return read().checkUserAccessToResource(userId, resourceName);
+    }
+
+    // Writers: each call publishes a new version
+
+    void addUser(const std::shared_ptr<UserType>& user) {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        std::unique_ptr<Version> next(new Version(*current.load()));
+        insertUser(*next, std::static_pointer_cast<const UserType>(user->clone()));
+        publish(next.release());
+    }
+
+    void addResource(const std::shared_ptr<ResourceType>& resource) {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        std::unique_ptr<Version> next(new Version(*current.load()));
+        next->resourcesByName.emplace(resource->getName(), std::make_shared<const ResourceType>(*resource));
+        publish(next.release());
+    }
+
+    void setAccessLevel(int userId, int accessLevel) {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        const Version* version = current.load();
+        size_t shard = shardOf(userId);
+        auto it = version->userShards[shard]->find(userId);
+        if (it == version->userShards[shard]->end()) {
+            throw std::runtime_error("Пользователь не найден");
+        }
+        auto user = std::static_pointer_cast<UserType>(it->second->clone());
+        user->setAccessLevel(accessLevel);
+
+        std::unique_ptr<Version> next(new Version(*version));
+        auto copy = std::make_shared<UserShard>(*next->userShards[shard]);
+        (*copy)[userId] = std::move(user);
+        next->userShards[shard] = std::move(copy);
+        publish(next.release());
+    }
+
+    // Replace the whole data set; readers keep seeing the old one until it is published
+    void loadFromFile(const std::string& usersFile, const std::string& resourcesFile) {
+        AccessControlSystem<UserType, ResourceType> loaded;
+        loaded.loadFromFileParallel(usersFile, resourcesFile);
+
+        // The loaded users are detached when the temporary system is destroyed
+        std::vector<UserShard> shards(USER_SHARDS);
+        std::unique_ptr<Version> next(new Version);
+        for (const auto& user : loaded.getUsers()) {
+            if (shards[shardOf(user->getId())].emplace(user->getId(), user).second) {
+                ++next->userCount;
+            }
+        }
+        for (auto& shard : shards) {
+            next->userShards.push_back(std::make_shared<const UserShard>(std::move(shard)));
+        }
+        for (const auto& resource : loaded.getResources()) {
+            next->resourcesByName.emplace(resource->getName(), resource);
+        }
+
+        std::lock_guard<std::mutex> lock(writerMutex);
+        publish(next.release());
+    }
+};
+
+// Approximate heap bytes of one std::string beyond the object itself:
+// short strings live in the object, longer ones in a malloc block
+inline size_t stringHeapBytes(const std::string& str) {
+    const size_t inlineCapacity = sizeof(std::string) - sizeof(size_t) - sizeof(char*) - 1;
+    if (str.capacity() <= inlineCapacity) {
+        return 0;
+    }
+    return (str.capacity() + 1 + sizeof(size_t) + 15) / 16 * 16;
+}
+
+// Local access-check service. Requests and responses are binary frames
+// over a Unix domain socket; a client may send any number of requests
+// without waiting (pipelining) and receives the responses in order.
+//   request:  int32 userId, uint16 nameLength, uint16 reserved, name bytes
+//   response: one status byte
+enum class AccessCheckStatus : uint8_t {
+    Denied = 0,
+    Granted = 1,
+    NotFound = 2
+};
+
+const size_t ACCESS_REQUEST_HEADER_SIZE = 8;
+
+inline void appendAccessRequest(std::string& out, int userId, const std::string& resourceName) {
+    char header[ACCESS_REQUEST_HEADER_SIZE] = {};
+    uint16_t length = static_cast<uint16_t>(resourceName.size());
+    std::memcpy(header, &userId, 4);
+    std::memcpy(header + 4, &length, 2);
+    out.append(header, ACCESS_REQUEST_HEADER_SIZE);
+    out.append(resourceName, 0, length);
+}
+
+// Reads the value that follows a command-line option, or returns fallback
+inline std::string optionValue(int argc, char* argv[], const std::string& name, const std::string& fallback) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (argv[i] == name) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+// Integer option; throws std::invalid_argument naming the option if the
+// value is not a whole number
+inline int optionInt(int argc, char* argv[], const std::string& name, int fallback) {
+    std::string value = optionValue(argc, argv, name, std::to_string(fallback));
+    int result = 0;
+    auto parsed = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (value.empty() || parsed.ec != std::errc() || parsed.ptr != value.data() + value.size()) {
+        throw std::invalid_argument("Неверное значение " + name + ": " + value);
+    }
+    return result;
+}
+
+// Data set used by the daemon and the load generator when no files are given
+inline void fillSyntheticData(AccessControlSystem<User, Resource>& system, int userCount, int resourceCount) {
+    for (int i = 0; i < userCount; ++i) {
+        system.addUser(system.createUser<Student>("Студент " + std::to_string(i), i, i % 6, "Т.РИ23"));
+    }
+    for (int i = 0; i < resourceCount; ++i) {
+        system.addResource(std::make_shared<Resource>("Ресурс " + std::to_string(i), i % 6));
+    }
+}
+
+#if defined(__linux__)
+
+std::atomic<bool> daemonStopRequested{false};
+
+extern "C" inline void requestDaemonStop(int) {
+    daemonStopRequested.store(true);
+}
+
+// Epoll event loop on N worker threads. Every worker has its own epoll
+// instance and accepts from the shared listening socket (EPOLLEXCLUSIVE
+// wakes one of them), so a connection is served by one thread only.
+// The system is only read, and must not be modified while the server runs.
+class AccessCheckServer {
+private:
+    struct Connection {
+        int fd;
+        std::string input;
+        size_t inputPos = 0;
+        std::string output;
+        size_t outputPos = 0;
+    };
+
+    // Per-worker buffers, reused for every batch of requests
+    struct Scratch {
+        std::vector<int> userIds;
+        std::vector<int> resourceIds;
+        AccessBatchResult result;
+        std::string name;
+    };
+
+    const AccessControlSystem<User, Resource>& system;
+    std::string socketPath;
+    unsigned threads;
+    int listenFd = -1;
+    std::atomic<uint64_t> requestsServed{0};
+
+    // Answers every complete request in the input buffer with one batch check.
+    // Returns false if the client sent a malformed frame.
+    bool processInput(Connection& connection, Scratch& scratch) {
+        scratch.userIds.clear();
+        scratch.resourceIds.clear();
+        const std::string& in = connection.input;
+        size_t pos = connection.inputPos;
+        while (in.size() - pos >= ACCESS_REQUEST_HEADER_SIZE) {
+            int32_t userId;
+            uint16_t length, reserved;
+            std::memcpy(&userId, in.data() + pos, 4);
+            std::memcpy(&length, in.data() + pos + 4, 2);
+            std::memcpy(&reserved, in.data() + pos + 6, 2);
+            if (reserved != 0) {
+                return false;
+            }
+            if (in.size() - pos - ACCESS_REQUEST_HEADER_SIZE < length) {
+                break;
+            }
+            scratch.name.assign(in.data() + pos + ACCESS_REQUEST_HEADER_SIZE, length);
+            scratch.userIds.push_back(userId);
+            scratch.resourceIds.push_back(system.findResourceId(scratch.name));
+            pos += ACCESS_REQUEST_HEADER_SIZE + length;
+        }
+        connection.inputPos = pos;
+        if (connection.inputPos == connection.input.size()) {
+            connection.input.clear();
+            connection.inputPos = 0;
+        } else if (connection.inputPos > connection.input.size() / 2) {
+            connection.input.erase(0, connection.inputPos);
+            connection.inputPos = 0;
+        }
+
+        const size_t count = scratch.userIds.size();
+        if (count == 0) {
+            return true;
+        }
+        system.checkAccessBatch(scratch.userIds.data(), scratch.resourceIds.data(), count, scratch.result);
+        for (size_t i = 0; i < count; ++i) {
+            AccessCheckStatus status = scratch.result.isMissing(i) ? AccessCheckStatus::NotFound
+                                     : scratch.result.isGranted(i) ? AccessCheckStatus::Granted
+                                     : AccessCheckStatus::Denied;
+            connection.output.push_back(static_cast<char>(status));
+        }
+        requestsServed.fetch_add(count, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Writes as much pending output as the socket takes. Returns false on error.
+    static bool flushOutput(Connection& connection) {
+        while (connection.outputPos < connection.output.size()) {
+            ssize_t written = send(connection.fd, connection.output.data() + connection.outputPos,
+                                   connection.output.size() - connection.outputPos, MSG_NOSIGNAL);
+            if (written < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            connection.outputPos += static_cast<size_t>(written);
+        }
+        connection.output.clear();
+        connection.outputPos = 0;
+        return true;
+    }
+
+    void workerLoop() {
+        int epollFd = epoll_create1(0);
+        if (epollFd < 0) {
+            std::cerr << "Не удалось создать epoll" << std::endl;
+            return;
+        }
+        epoll_event listenEvent{};
+        listenEvent.events = EPOLLIN | EPOLLEXCLUSIVE;
+        listenEvent.data.ptr = nullptr;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent);
+
+        std::unordered_map<int, std::unique_ptr<Connection>> connections;
+        Scratch scratch;
+        epoll_event events[64];
+        char buffer[65536];
+
+        auto closeConnection = [&](Connection& connection) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+            close(connection.fd);
+            connections.erase(connection.fd);
+        };
+
+        while (!daemonStopRequested.load()) {
+            int ready = epoll_wait(epollFd, events, 64, 100);
+            for (int i = 0; i < ready; ++i) {
+                if (events[i].data.ptr == nullptr) {
+                    int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (fd < 0) {
+                        continue;
+                    }
+                    auto connection = std::make_unique<Connection>();
+                    connection->fd = fd;
+                    epoll_event event{};
+                    event.events = EPOLLIN;
+                    event.data.ptr = connection.get();
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+                    connections.emplace(fd, std::move(connection));
+                    continue;
+                }
+
+                Connection& connection = *static_cast<Connection*>(events[i].data.ptr);
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeConnection(connection);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+                    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                        closeConnection(connection);
+                        continue;
+                    }
+                    if (received > 0) {
+                        connection.input.append(buffer, static_cast<size_t>(received));
+                        if (!processInput(connection, scratch)) {
+                            closeConnection(connection);
+                            continue;
+                        }
+                    }
+                }
+                if (!flushOutput(connection)) {
+                    closeConnection(connection);
+                    continue;
+                }
+                // A client that does not read its responses is not read from
+                // either, until the pending output has been sent
+                epoll_event event{};
+                event.events = connection.output.empty() ? EPOLLIN : EPOLLOUT;
+                event.data.ptr = &connection;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+            }
+        }
+
+        for (auto& entry : connections) {
+            close(entry.first);
+        }
+        close(epollFd);
+    }
+
+public:
+    AccessCheckServer(const AccessControlSystem<User, Resource>& system, const std::string& socketPath,
+                      unsigned threads)
+        : system(system), socketPath(socketPath), threads(std::max(1u, threads)) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Слишком длинный путь к сокету");
+        }
+        std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) {
+            throw std::runtime_error("Не удалось создать сокет");
+        }
+        unlink(socketPath.c_str());
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listenFd, SOMAXCONN) != 0) {
+            close(listenFd);
+            throw std::runtime_error("Не удалось открыть сокет " + socketPath);
+        }
+    }
+
+    ~AccessCheckServer() {
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+
+    AccessCheckServer(const AccessCheckServer&) = delete;
+    AccessCheckServer& operator=(const AccessCheckServer&) = delete;
+
+    uint64_t served() const { return requestsServed.load(); }
+
+    // Serves requests until daemonStopRequested is set
+    void run() {
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < threads; ++i) {
+            workers.emplace_back(&AccessCheckServer::workerLoop, this);
+        }
+        workerLoop();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+};
+
+// laba10 --daemon SOCKET [--threads N] [--storage shared|arena] [--snapshot FILE | --users N --resources N]
+inline int runDaemon(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Использование: --daemon SOCKET [--threads N] [--storage shared|arena] "
+                     "[--snapshot FILE | --users N --resources N]" << std::endl;
+        return 1;
+    }
+    try {
+        std::string storageName = optionValue(argc, argv, "--storage", "shared");
+        if (storageName != "shared" && storageName != "arena") {
+            throw std::invalid_argument("--storage: ожидается shared или arena");
+        }
+        AccessControlSystem<User, Resource> system(storageName == "arena" ? UserStorage::Arena : UserStorage::Shared);
+        std::string snapshot = optionValue(argc, argv, "--snapshot", "");
+        if (!snapshot.empty()) {
+            system.loadSnapshot(snapshot);
+        } else {
+            fillSyntheticData(system, optionInt(argc, argv, "--users", 100000),
+                              optionInt(argc, argv, "--resources", 1000));
+        }
+        unsigned threads = static_cast<unsigned>(
+            optionInt(argc, argv, "--threads", static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))));
+
+        AccessCheckServer server(system, argv[2], threads);
+        std::signal(SIGINT, requestDaemonStop);
+        std::signal(SIGTERM, requestDaemonStop);
+        std::cout << "Сервер проверки доступа: " << argv[2] << ", потоков: " << threads
+                  << ", пользователей: " << system.getUsers().size()
+                  << ", ресурсов: " << system.getResources().size() << std::endl;
+        server.run();
+        std::cout << "Сервер остановлен, обработано запросов: " << server.served() << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// laba10 --client SOCKET [--connections C] [--requests R] [--pipeline P] [--users N --resources N]
+// Every connection sends R requests in batches of P and waits for each
+// batch; the latency of a request is the round trip of its batch.
+inline int runLoadClient(int argc, char* argv[]) {
+    auto usage = []() {
+        std::cerr << "Использование: --client SOCKET [--connections C] [--requests R] [--pipeline P]"
+                  << " [--users N --resources N]" << std::endl;
+    };
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+    const std::string socketPath = argv[2];
+    int connections, requests, pipeline, userCount, resourceCount;
+    try {
+        connections = std::max(1, optionInt(argc, argv, "--connections", 4));
+        requests = std::max(1, optionInt(argc, argv, "--requests", 100000));
+        pipeline = std::max(1, optionInt(argc, argv, "--pipeline", 16));
+        userCount = std::max(1, optionInt(argc, argv, "--users", 100000));
+        resourceCount = std::max(1, optionInt(argc, argv, "--resources", 1000));
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        usage();
+        return 1;
+    }
+
+    std::vector<std::vector<float>> latencies(connections);
+    std::vector<std::array<uint64_t, 3>> statusCounts(connections, std::array<uint64_t, 3>{});
+    std::atomic<bool> failed{false};
+
+    auto worker = [&](int index) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            failed.store(true);
+            if (fd >= 0) {
+                close(fd);
+            }
+            return;
+        }
+
+        std::mt19937 gen(42 + index);
+        std::uniform_int_distribution<int> userDist(0, userCount - 1);
+        std::uniform_int_distribution<int> resourceDist(0, resourceCount - 1);
+        std::vector<std::string> resourceNames;
+        resourceNames.reserve(resourceCount);
+        for (int i = 0; i < resourceCount; ++i) {
+            resourceNames.push_back("Ресурс " + std::to_string(i));
+        }
+
+        std::string batch;
+        std::vector<char> responses(pipeline);
+        latencies[index].reserve(requests);
+        for (int sent = 0; sent < requests && !failed.load(); sent += pipeline) {
+            const int count = std::min(pipeline, requests - sent);
+            batch.clear();
+            for (int i = 0; i < count; ++i) {
+                appendAccessRequest(batch, userDist(gen), resourceNames[resourceDist(gen)]);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            size_t written = 0;
+            while (written < batch.size()) {
+                ssize_t n = send(fd, batch.data() + written, batch.size() - written, MSG_NOSIGNAL);
+                if (n <= 0) {
+                    failed.store(true);
+                    break;
+                }
+                written += static_cast<size_t>(n);
+            }
+            size_t received = 0;
+            while (!failed.load() && received < static_cast<size_t>(count)) {
+                ssize_t n = recv(fd, responses.data() + received, count - received, 0);
+                if (n <= 0) {
+                    failed.store(true);
+                    break;
+                }
+                received += static_cast<size_t>(n);
+            }
+            float us = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+            for (size_t i = 0; i < received; ++i) {
+                latencies[index].push_back(us);
+                ++statusCounts[index][std::min<size_t>(static_cast<uint8_t>(responses[i]), 2)];
+            }
+        }
+        close(fd);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < connections; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (failed.load()) {
+        std::cerr << "Ошибка соединения с " << socketPath << std::endl;
+        return 1;
+    }
+
+    std::vector<float> all;
+    std::array<uint64_t, 3> totals{};
+    for (int i = 0; i < connections; ++i) {
+        all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+        for (int s = 0; s < 3; ++s) {
+            totals[s] += statusCounts[i][s];
+        }
+    }
+    auto percentile = [&all](double p) {
+        size_t k = std::min(all.size() - 1, static_cast<size_t>(p * all.size()));
+        std::nth_element(all.begin(), all.begin() + k, all.end());
+        return all[k];
+    };
+    std::cout << "Соединений: " << connections << ", конвейер: " << pipeline
+              << ", запросов: " << all.size() << std::endl;
+    std::cout << "Запросов в секунду: " << static_cast<long long>(all.size() / seconds) << std::endl;
+    std::cout << "Задержка p50: " << percentile(0.50) << " мкс, p99: " << percentile(0.99) << " мкс" << std::endl;
+    std::cout << "Разрешено: " << totals[1] << ", запрещено: " << totals[0]
+              << ", не найдено: " << totals[2] << std::endl;
+    return 0;
+}
+
+#else
+
+inline int runDaemon(int, char*[]) {
+    std::cerr << "Режим сервера поддерживается только в Linux" << std::endl;
+    return 1;
+}
+
+inline int runLoadClient(int, char*[]) {
+    std::cerr << "Режим клиента поддерживается только в Linux" << std::endl;
+    return 1;
+}
+
+#endif
+
+// Buffers everything written to a stream in batch mode: std::endl does not
+// flush it, so output is written in large blocks instead of line by line.
+// The stream is redirected for the lifetime of the object.
+class BatchOutput : public std::streambuf {
+private:
+    std::ostream& stream;
+    std::streambuf* target;
+    std::vector<char> buffer;
+
+    void flushBuffer() {
+        target->sputn(pbase(), pptr() - pbase());
+        target->pubsync();
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        flushBuffer();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override {
+        return 0;
+    }
+
+public:
+    explicit BatchOutput(std::ostream& stream, size_t size = 1 << 16)
+        : stream(stream), target(stream.rdbuf()), buffer(size) {
+        setp(buffer.data(), buffer.data() + buffer.size());
+        stream.rdbuf(this);
+    }
+
+    ~BatchOutput() {
+        stream.rdbuf(target);
+        flushBuffer();
+    }
+
+    BatchOutput(const BatchOutput&) = delete;
+    BatchOutput& operator=(const BatchOutput&) = delete;
+};
+
+// Arguments of a batch command line, split on spaces; the last argument
+// may take the rest of the line, so names can contain spaces
+class CommandArgs {
+private:
+    std::string_view rest;
+
+    void skipSpaces() {
+        while (!rest.empty() && (rest.front() == ' ' || rest.front() == '\t')) {
+            rest.remove_prefix(1);
+        }
+    }
+
+public:
+    explicit CommandArgs(std::string_view line) : rest(line) {
+        while (!rest.empty() && (rest.back() == '\r' || rest.back() == ' ' || rest.back() == '\t')) {
+            rest.remove_suffix(1);
+        }
+    }
+
+    // True for empty lines and # comments
+    bool blank() {
+        skipSpaces();
+        return rest.empty() || rest.front() == '#';
+    }
+
+    std::string_view word() {
+        skipSpaces();
+        if (rest.empty()) {
+            throw std::runtime_error("Не хватает аргументов");
+        }
+        size_t end = rest.find_first_of(" \t");
+        std::string_view value = rest.substr(0, end);
+        rest.remove_prefix(value.size());
+        return value;
+    }
+
+    int number() {
+        return parseIntField(word());
+    }
+
+    std::string text() {
+        skipSpaces();
+        if (rest.empty()) {
+            throw std::runtime_error("Не хватает аргументов");
+        }
+        std::string value(rest);
+        rest = std::string_view();
+        return value;
+    }
+};
+
+// Number and total time of the executed commands of one type
+struct BatchCommandStats {
+    uint64_t count = 0;
+    double seconds = 0;
+};
+
+// Prints total wall time and throughput per command type to std::cerr,
+// so that stdout carries only the results of the commands
+inline void reportBatchStats(const std::map<std::string, BatchCommandStats>& stats, double seconds, size_t errors) {
+    uint64_t total = 0;
+    for (const auto& entry : stats) {
+        total += entry.second.count;
+    }
+    std::cerr << "Команд: " << total << ", ошибок: " << errors << ", время: " << seconds * 1000 << " мс, "
+              << static_cast<long long>(total / std::max(seconds, 1e-9)) << " команд/с" << std::endl;
+    for (const auto& entry : stats) {
+        std::cerr << "  " << entry.first << ": " << entry.second.count << ", "
+                  << static_cast<long long>(entry.second.count / std::max(entry.second.seconds, 1e-9))
+                  << " команд/с" << std::endl;
+    }
+}
+
+// laba10 --batch [FILE]: executes commands from FILE (or stdin) without
+// prompts, one per line; empty lines and lines starting with # are skipped.
+//   add_user KIND ID LEVEL EXTRA NAME   KIND is User, Student, Teacher or Administrator;
+//                                       EXTRA is the group, department or admin level (- for User)
+//   add_resource LEVEL NAME
+//   set_level ID LEVEL
+//   check ID RESOURCE                   prints 1 or 0
+//   search QUERY                        prints the match count and up to 10 IDs
+//   save USERS RESOURCES | load USERS RESOURCES
+//   save_snapshot FILE | load_snapshot FILE
+inline int runBatch(int argc, char* argv[]) {
+    std::ifstream file;
+    std::istream* input = &std::cin;
+    if (argc > 2 && std::string(argv[2]) != "-") {
+        file.open(argv[2]);
+        if (!file) {
+            std::cerr << "Не удалось открыть файл команд " << argv[2] << std::endl;
+            return 1;
+        }
+        input = &file;
+    }
+
+    AccessControlSystem<User, Resource> system;
+    std::map<std::string, BatchCommandStats> stats;
+    size_t errors = 0;
+    auto start = std::chrono::steady_clock::now();
+    {
+        BatchOutput output(std::cout);
+        std::string line;
+        while (std::getline(*input, line)) {
+            CommandArgs args(line);
+            if (args.blank()) {
+                continue;
+            }
+            std::string_view command = args.word();
+            auto commandStart = std::chrono::steady_clock::now();
+            try {
+                if (command == "check") {
+                    int userId = args.number();
+                    std::cout << system.checkUserAccessToResource(userId, args.text()) << '\n';
+                } else if (command == "add_user") {
+                    std::string_view kind = args.word();
+                    int id = args.number();
+                    int level = args.number();
+                    std::string extra(args.word());
+                    std::string name = args.text();
+                    if (kind == "Student") {
+                        system.addUser(std::make_shared<Student>(name, id, level, extra));
+                    } else if (kind == "Teacher") {
+                        system.addUser(std::make_shared<Teacher>(name, id, level, extra));
+                    } else if (kind == "Administrator") {
+                        system.addUser(std::make_shared<Administrator>(name, id, level, parseIntField(extra)));
+                    } else if (kind == "User") {
+                        system.addUser(std::make_shared<User>(name, id, level));
+                    } else {
+                        throw std::runtime_error("Неизвестный тип пользователя: " + std::string(kind));
+                    }
+                } else if (command == "add_resource") {
+                    int level = args.number();
+                    system.addResource(std::make_shared<Resource>(args.text(), level));
+                } else if (command == "set_level") {
+                    int id = args.number();
+                    int level = args.number();
+                    auto user = system.searchUserById(id);
+                    if (!user) {
+                        throw std::runtime_error("Пользователь не найден");
+                    }
+                    user->setAccessLevel(level);
+                } else if (command == "search") {
+                    auto found = system.findUsersByTokens(args.text());
+                    std::cout << found.size();
+                    for (size_t i = 0; i < found.size() && i < 10; ++i) {
+                        std::cout << ' ' << found[i].getId();
+                    }
+                    std::cout << '\n';
+                } else if (command == "save") {
+                    std::string usersFile(args.word());
+                    system.saveToFile(usersFile, args.text());
+                } else if (command == "load") {
+                    std::string usersFile(args.word());
+                    system.loadFromFile(usersFile, args.text());
+                } else if (command == "save_snapshot") {
+                    system.saveSnapshot(args.text());
+                } else if (command == "load_snapshot") {
+                    system.loadSnapshot(args.text());
+                } else {
+                    throw std::runtime_error("Неизвестная команда: " + std::string(command));
+                }
+            } catch (const std::exception& e) {
+                std::cout << "Ошибка: " << e.what() << '\n';
+                ++errors;
+            }
+            BatchCommandStats& entry = stats[std::string(command)];
+            ++entry.count;
+            entry.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - commandStart).count();
+        }
+    }
+    reportBatchStats(stats, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), errors);
+    return errors == 0 ? 0 : 2;
+}
+
+// Benchmark: average latency of checkUserAccessToResource as the user count grows,
+// compared with the former linear scan over the users vector
+void benchmarkAccessChecks() {
+    const int resourceCount = 1000;
+    const int checks = 200000;
+    std::mt19937 gen(42);
+
+    for (int userCount : {1000, 10000, 100000, 500000}) {
+        AccessControlSystem<User, Resource> bench;
+        std::vector<std::shared_ptr<User>> linearUsers;
+        linearUsers.reserve(userCount);
+        for (int i = 0; i < userCount; ++i) {
+            auto user = std::make_shared<Student>("Студент " + std::to_string(i), i, i % 6, "Т.РИ23");
+            bench.addUser(user);
+            linearUsers.push_back(user);
+        }
+        for (int i = 0; i < resourceCount; ++i) {
+            bench.addResource(std::make_shared<Resource>("Ресурс " + std::to_string(i), i % 6));
+        }
+
+        std::uniform_int_distribution<int> userDist(0, userCount - 1);
+        std::uniform_int_distribution<int> resourceDist(0, resourceCount - 1);
+        std::vector<std::pair<int, std::string>> queries;
+        queries.reserve(checks);
+        for (int i = 0; i < checks; ++i) {
+            queries.emplace_back(userDist(gen), "Ресурс " + std::to_string(resourceDist(gen)));
+        }
+
+        long long granted = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& query : queries) {
+            granted += bench.checkUserAccessToResource(query.first, query.second);
+        }
+        auto end = std::chrono::steady_clock::now();
+        double indexedNs = std::chrono::duration<double, std::nano>(end - start).count() / checks;
+
+        // The linear scan is far slower, so it is measured on a smaller sample
+        int linearChecks = std::max(1, std::min(checks, 20000000 / userCount));
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < linearChecks; ++i) {
+            int userId = queries[i].first;
+            auto it = std::find_if(linearUsers.begin(), linearUsers.end(),
+                [userId](const std::shared_ptr<User>& user) { return user->getId() == userId; });
+            granted += (*it)->getAccessLevel();
+        }
+        end = std::chrono::steady_clock::now();
+        double linearNs = std::chrono::duration<double, std::nano>(end - start).count() / linearChecks;
+
+        std::cout << "Пользователей: " << userCount
+                  << ", индекс: " << indexedNs << " нс/проверка"
+                  << ", линейный поиск: " << linearNs << " нс/проверка"
+                  << " (" << granted << ")" << std::endl;
+    }
+}
+
+// Benchmark: per-pair checkUserAccessToResource against checkAccessBatch
+void benchmarkBatchChecks() {
+    const int userCount = 100000;
+    const int resourceCount = 1000;
+    const int pairs = 1000000;
+    std::mt19937 gen(42);
+
+    AccessControlSystem<User, Resource> bench;
+    for (int i = 0; i < userCount; ++i) {
+        bench.addUser(std::make_shared<Student>("Студент " + std::to_string(i), i, i % 6, "Т.РИ23"));
+    }
+    std::vector<std::string> resourceNames;
+    for (int i = 0; i < resourceCount; ++i) {
+        resourceNames.push_back("Ресурс " + std::to_string(i));
+        bench.addResource(std::make_shared<Resource>(resourceNames.back(), i % 6));
+    }
+
+    // Every 100th pair refers to a missing user
+    std::uniform_int_distribution<int> userDist(0, userCount - 1);
+    std::uniform_int_distribution<int> resourceDist(0, resourceCount - 1);
+    std::vector<int> userIds(pairs), resourceIds(pairs);
+    for (int i = 0; i < pairs; ++i) {
+        userIds[i] = (i % 100 == 0) ? userCount + i : userDist(gen);
+        resourceIds[i] = resourceDist(gen);
+    }
+
+    long long grantedSingle = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < pairs; ++i) {
+        try {
+            grantedSingle += bench.checkUserAccessToResource(userIds[i], resourceNames[resourceIds[i]]);
+        } catch (const std::exception&) {
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double singleNs = std::chrono::duration<double, std::nano>(end - start).count() / pairs;
+
+    AccessBatchResult result;
+    start = std::chrono::steady_clock::now();
+    bench.checkAccessBatch(userIds.data(), resourceIds.data(), pairs, result);
+    end = std::chrono::steady_clock::now();
+    double batchNs = std::chrono::duration<double, std::nano>(end - start).count() / pairs;
+
+    long long grantedBatch = 0, missing = 0;
+    for (int i = 0; i < pairs; ++i) {
+        grantedBatch += result.isGranted(i);
+        missing += result.isMissing(i);
+    }
+
+    std::cout << "По одной паре: " << singleNs << " нс/пара, разрешено: " << grantedSingle << std::endl;
+    std::cout << "Пакетом: " << batchNs << " нс/пара, разрешено: " << grantedBatch
+              << ", не найдено: " << missing << std::endl;
+}
+
+// Benchmark: cold load of the text format against the binary snapshot,
+// and access checks served directly from the mapped snapshot
+void benchmarkSnapshotLoad() {
+    const int userCount = 1000000;
+    const int resourceCount = 1000;
+    const char* groups[] = {"Т.РИ21", "Т.РИ22", "Т.РИ23", "Т.РИ24"};
+
+    {
+        AccessControlSystem<User, Resource> source;
+        for (int i = 0; i < userCount; ++i) {
+            switch (i % 3) {
+                case 0:
+                    source.addUser(std::make_shared<Student>("Студент_" + std::to_string(i), i, i % 6, groups[i % 4]));
+                    break;
+                case 1:
+                    source.addUser(std::make_shared<Teacher>("Преподаватель_" + std::to_string(i), i, i % 6, "Кафедра"));
+                    break;
+                default:
+                    source.addUser(std::make_shared<Administrator>("Администратор_" + std::to_string(i), i, 5, 1));
+                    break;
+            }
+        }
+        for (int i = 0; i < resourceCount; ++i) {
+            source.addResource(std::make_shared<Resource>("Ресурс_" + std::to_string(i), i % 6));
+        }
+        source.saveToFile("bench_users.txt", "bench_resources.txt");
+        source.saveSnapshot("bench_snapshot.bin");
+    }
+
+    AccessControlSystem<User, Resource> target;
+    auto start = std::chrono::steady_clock::now();
+    target.loadFromFile("bench_users.txt", "bench_resources.txt");
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Текстовый формат: " << std::chrono::duration<double, std::milli>(end - start).count() << " мс" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    target.loadSnapshot("bench_snapshot.bin");
+    end = std::chrono::steady_clock::now();
+    std::cout << "Двоичный снимок в объекты: " << std::chrono::duration<double, std::milli>(end - start).count() << " мс" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    MappedSnapshot snapshot("bench_snapshot.bin");
+    long long granted = 0;
+    for (int i = 0; i < 100000; ++i) {
+        granted += snapshot.checkUserAccessToResource(i * 7 % userCount, "Ресурс_" + std::to_string(i % resourceCount));
+    }
+    end = std::chrono::steady_clock::now();
+    std::cout << "Отображение снимка и 100000 проверок на месте: "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " мс (" << granted << ")" << std::endl;
+
+    std::remove("bench_users.txt");
+    std::remove("bench_resources.txt");
+    std::remove("bench_snapshot.bin");
+}
+
+// Benchmark: loadFromFile against loadFromFileParallel with a growing number of threads
+void benchmarkParallelLoad() {
+    const int userCount = 2000000;
+    const int resourceCount = 1000;
+    {
+        AccessControlSystem<User, Resource> source;
+        for (int i = 0; i < userCount; ++i) {
+            if (i % 2 == 0) {
+                source.addUser(std::make_shared<Student>("Студент_" + std::to_string(i), i, i % 6, "Т.РИ23"));
+            } else {
+                source.addUser(std::make_shared<Teacher>("Преподаватель_" + std::to_string(i), i, i % 6, "Кафедра"));
+            }
+        }
+        for (int i = 0; i < resourceCount; ++i) {
+            source.addResource(std::make_shared<Resource>("Ресурс_" + std::to_string(i), i % 6));
+        }
+        source.saveToFile("bench_users.txt", "bench_resources.txt");
+    }
+
+    AccessControlSystem<User, Resource> target;
+    auto start = std::chrono::steady_clock::now();
+    target.loadFromFile("bench_users.txt", "bench_resources.txt");
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "loadFromFile: " << std::chrono::duration<double, std::milli>(end - start).count() << " мс" << std::endl;
+
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        LoadTimings t = target.loadFromFileParallel("bench_users.txt", "bench_resources.txt", threads);
+        std::cout << "Потоков: " << t.threads << ", чтение: " << t.readMs << " мс, разбор: " << t.parseMs
+                  << " мс, слияние: " << t.mergeMs << " мс, индексы: " << t.indexMs << " мс, всего: "
+                  << t.readMs + t.parseMs + t.mergeMs + t.indexMs << " мс" << std::endl;
+    }
+
+    std::remove("bench_users.txt");
+    std::remove("bench_resources.txt");
+}
+
+// Benchmark: read throughput of ConcurrentAccessControlSystem with a growing
+// number of reader threads while a writer keeps changing access levels
+void benchmarkConcurrentReads() {
+    const int userCount = 100000;
+    const int resourceCount = 100;
+    const auto duration = std::chrono::milliseconds(500);
+
+    ConcurrentAccessControlSystem<User, Resource> bench;
+    {
+        AccessControlSystem<User, Resource> source;
+        for (int i = 0; i < userCount; ++i) {
+            source.addUser(std::make_shared<Student>("Студент_" + std::to_string(i), i, i % 6, "Т.РИ23"));
+        }
+        for (int i = 0; i < resourceCount; ++i) {
+            source.addResource(std::make_shared<Resource>("Ресурс_" + std::to_string(i), i % 6));
+        }
+        source.saveToFile("bench_users.txt", "bench_resources.txt");
+        bench.loadFromFile("bench_users.txt", "bench_resources.txt");
+        std::remove("bench_users.txt");
+        std::remove("bench_resources.txt");
+    }
+    std::vector<std::string> resourceNames;
+    for (int i = 0; i < resourceCount; ++i) {
+        resourceNames.push_back("Ресурс_" + std::to_string(i));
+    }
+
+    unsigned maxThreads = std::max(4u, std::thread::hardware_concurrency());
+    for (unsigned readers = 1; readers <= maxThreads; readers *= 2) {
+        std::atomic<bool> stop{false};
+        std::atomic<long long> totalReads{0};
+        long long writes = 0;
+
+        std::vector<std::thread> pool;
+        for (unsigned r = 0; r < readers; ++r) {
+            pool.emplace_back([&, r]() {
+                std::mt19937 gen(r);
+                std::uniform_int_distribution<int> userDist(0, userCount - 1);
+                std::uniform_int_distribution<int> resourceDist(0, resourceCount - 1);
+                long long reads = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    bench.checkUserAccessToResource(userDist(gen), resourceNames[resourceDist(gen)]);
+                    ++reads;
+                }
+                totalReads += reads;
+            });
+        }
+        std::thread writer([&]() {
+            std::mt19937 gen(12345);
+            std::uniform_int_distribution<int> userDist(0, userCount - 1);
+            while (!stop.load(std::memory_order_relaxed)) {
+                bench.setAccessLevel(userDist(gen), static_cast<int>(gen() % 6));
+                ++writes;
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+
+        std::this_thread::sleep_for(duration);
+        stop = true;
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        writer.join();
+
+        double seconds = std::chrono::duration<double>(duration).count();
+        std::cout << "Читателей: " << readers << ", чтений/с: " << static_cast<long long>(totalReads / seconds)
+                  << ", записей/с: " << static_cast<long long>(writes / seconds) << std::endl;
+    }
+}
+
+// Benchmark: exact scan over all users against the inverted name index
+void benchmarkNameSearch() {
+    const int userCount = 1000000;
+    const char* surnames[] = {"Иванов", "Петров", "Сидоров", "Михалёв", "Подколзин", "Андреев", "Смирнов", "Кузнецов"};
+    const char* firstNames[] = {"Андрей", "Максим", "Алина", "Любовь", "Иван", "Мария", "Ольга", "Пётр"};
+    const char* patronymics[] = {"Александрович", "Викторович", "Иванович", "Петрович", "Сергеевич"};
+
+    AccessControlSystem<User, Resource> bench;
+    std::mt19937 gen(42);
+    for (int i = 0; i < userCount; ++i) {
+        std::string name = std::string(surnames[gen() % 8]) + std::to_string(i % 5000) + " " +
+                           firstNames[gen() % 8] + " " + patronymics[gen() % 5];
+        bench.addUser(std::make_shared<Student>(name, i, i % 6, "Т.РИ23"));
+    }
+    std::vector<std::shared_ptr<User>> all(bench.getUsers().begin(), bench.getUsers().end());
+    std::string target(bench.getUsers()[userCount / 2]->getName());
+
+    const int queries = 20;
+    auto start = std::chrono::steady_clock::now();
+    size_t scanned = 0;
+    for (int q = 0; q < queries; ++q) {
+        for (const auto& user : all) {
+            scanned += user->getName() == target;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Полный перебор: " << std::chrono::duration<double, std::micro>(end - start).count() / queries
+              << " мкс/запрос (" << scanned / queries << ")" << std::endl;
+
+    struct Query { const char* title; std::string text; bool prefix; bool exact; };
+    std::vector<Query> cases = {
+        {"Точное имя", target, false, true},
+        {"Одно слово", "Михалёв42", false, false},
+        {"Слова (И)", "Михалев42 алина", false, false},
+        {"Префиксы (И)", "Мих Ал Вик", true, false},
+    };
+    for (const auto& c : cases) {
+        const int repeats = 1000;
+        size_t found = 0;
+        start = std::chrono::steady_clock::now();
+        for (int q = 0; q < repeats; ++q) {
+            found += c.exact ? bench.findUsersByName(c.text).size() : bench.findUsersByTokens(c.text, c.prefix).size();
+        }
+        end = std::chrono::steady_clock::now();
+        std::cout << c.title << " \"" << c.text << "\": "
+                  << std::chrono::duration<double, std::micro>(end - start).count() / repeats
+                  << " мкс/запрос, найдено: " << found / repeats << std::endl;
+    }
+}
+
+// Memory report of the two user storage modes: bytes per user of the users
+// themselves (objects, reference counts, names), time to fill the system and
+// time of a scan over all users that reads every name and level
+void benchmarkUserStorage() {
+    const int userCount = 1000000;
+    const char* groups[] = {"Т.РИ21", "Т.РИ22", "Т.РИ23", "Т.РИ24"};
+    const char* departments[] = {"Кафедра программного обеспечения", "Кафедра прикладной математики"};
+
+    for (UserStorage storage : {UserStorage::Shared, UserStorage::Arena}) {
+        AccessControlSystem<User, Resource> bench(storage);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < userCount; ++i) {
+            std::string name = "Пользователь Номер " + std::to_string(i);
+            switch (i % 3) {
+                case 0:
+                    bench.addUser(bench.createUser<Student>(name, i, i % 6, groups[i % 4]));
+                    break;
+                case 1:
+                    bench.addUser(bench.createUser<Teacher>(name, i, i % 6, departments[i % 2]));
+                    break;
+                default:
+                    bench.addUser(bench.createUser<Administrator>(name, i, 5, 1));
+                    break;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        double fillMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        const std::string target = "Пользователь Номер " + std::to_string(userCount / 2);
+        start = std::chrono::steady_clock::now();
+        size_t found = 0;
+        long long levels = 0;
+        for (const auto& user : bench.getUsers()) {
+            found += user->getName() == target;
+            levels += user->getAccessLevel();
+        }
+        end = std::chrono::steady_clock::now();
+        double scanMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        size_t bytes = bench.userStorageBytes();
+        std::cout << (storage == UserStorage::Arena ? "Арена" : "shared_ptr") << ": " << bytes / userCount
+                  << " байт/польз. (" << bytes / (1024 * 1024) << " МиБ), заполнение " << fillMs
+                  << " мс, перебор " << scanMs << " мс (" << found << ", " << levels << ")" << std::endl;
+    }
+}
+
+// Benchmark: repeated (user, resource) pairs without and with the decision cache
+void benchmarkDecisionCache() {
+    const int userCount = 1000000;
+    const int resourceCount = 1000;
+    const int checks = 2000000;
+
+    AccessControlSystem<User, Resource> bench;
+    for (int i = 0; i < userCount; ++i) {
+        bench.addUser(std::make_shared<Student>("Студент_" + std::to_string(i), i, i % 6, "Т.РИ23"));
+    }
+    for (int i = 0; i < resourceCount; ++i) {
+        bench.addResource(std::make_shared<Resource>("Ресурс_" + std::to_string(i), i % 6));
+    }
+
+    // Skewed traffic: most checks come from a small set of hot pairs
+    std::mt19937 gen(42);
+    std::vector<std::pair<int, int>> hotPairs(50000);
+    for (auto& pair : hotPairs) {
+        pair = {static_cast<int>(gen() % userCount), static_cast<int>(gen() % resourceCount)};
+    }
+    std::vector<std::pair<int, int>> queries(checks);
+    for (auto& query : queries) {
+        if (gen() % 10 < 9) {
+            query = hotPairs[gen() % hotPairs.size()];
+        } else {
+            query = {static_cast<int>(gen() % userCount), static_cast<int>(gen() % resourceCount)};
+        }
+    }
+
+    for (size_t capacity : {size_t(0), size_t(16384), size_t(65536), size_t(262144)}) {
+        if (capacity == 0) {
+            bench.disableDecisionCache();
+        } else {
+            bench.enableDecisionCache(capacity);
+        }
+        long long granted = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& query : queries) {
+            granted += bench.checkUserAccessToResource(query.first, query.second);
+        }
+        auto end = std::chrono::steady_clock::now();
+        AccessCacheStats stats = bench.decisionCacheStats();
+        std::cout << "Кэш: " << capacity << " записей, "
+                  << std::chrono::duration<double, std::nano>(end - start).count() / checks << " нс/проверка"
+                  << ", попаданий: " << stats.hits << ", промахов: " << stats.misses
+                  << ", вытеснений: " << stats.evictions << " (" << granted << ")" << std::endl;
+    }
+    bench.disableDecisionCache();
+}
+
+// Benchmark: full re-sort of the user vector against the ordered level index
+void benchmarkLevelIndex() {
+    const int userCount = 1000000;
+    AccessControlSystem<User, Resource> bench;
+    std::vector<std::shared_ptr<User>> copy;
+    copy.reserve(userCount);
+    std::mt19937 gen(42);
+    for (int i = 0; i < userCount; ++i) {
+        auto user = std::make_shared<Student>("Студент_" + std::to_string(i), i, static_cast<int>(gen() % 10), "Т.РИ23");
+        bench.addUser(user);
+        copy.push_back(user);
+    }
+    bench.addResource(std::make_shared<Resource>("Панель администратора", 8));
+
+    auto start = std::chrono::steady_clock::now();
+    std::sort(copy.begin(), copy.end(), [](const std::shared_ptr<User>& a, const std::shared_ptr<User>& b) {
+        return a->getAccessLevel() < b->getAccessLevel();
+    });
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "std::sort всех пользователей: " << std::chrono::duration<double, std::milli>(end - start).count()
+              << " мс" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    bench.sortUsersByAccessLevel();
+    end = std::chrono::steady_clock::now();
+    std::cout << "sortUsersByAccessLevel по индексу: " << std::chrono::duration<double, std::milli>(end - start).count()
+              << " мс" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    size_t count = bench.countUsersWithLevelAtLeast(8);
+    AccessLevelCursor cursor;
+    auto page = bench.usersWithLevelAtLeastPage(8, cursor, 20);
+    end = std::chrono::steady_clock::now();
+    std::cout << "Кто может открыть «Панель администратора»: " << count << " польз., первая страница за "
+              << std::chrono::duration<double, std::micro>(end - start).count() << " мкс" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100000; ++i) {
+        copy[gen() % userCount]->setAccessLevel(static_cast<int>(gen() % 10));
+    }
+    end = std::chrono::steady_clock::now();
+    std::cout << "100000 изменений уровня с обновлением индекса: "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " мс" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    size_t total = bench.usersWhoCanAccess("Панель администратора").size();
+    end = std::chrono::steady_clock::now();
+    std::cout << "usersWhoCanAccess целиком: " << total << " польз. за "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " мс" << std::endl;
+}
+
+// Benchmark: journaled mutations with an fsync per record against group
+// commit, and recovery from a long journal against a compacted snapshot
+void benchmarkJournal() {
+    const std::string snapshotFile = "journal_bench.snap";
+    const std::string journalFile = "journal_bench.journal";
+    auto removeFiles = [&]() {
+        std::remove(snapshotFile.c_str());
+        std::remove(journalFile.c_str());
+    };
+    auto mutate = [](AccessControlSystem<User, Resource>& bench, int count) {
+        std::mt19937 gen(42);
+        const auto& users = bench.getUsers();
+        for (int i = 0; i < count; ++i) {
+            users[gen() % users.size()]->setAccessLevel(static_cast<int>(gen() % 10));
+        }
+    };
+
+    const int userCount = 200000;
+    JournalOptions unbounded;
+    unbounded.compactAfterRecords = UINT64_MAX;
+    removeFiles();
+    {
+        AccessControlSystem<User, Resource> bench;
+        bench.openJournal(snapshotFile, journalFile, unbounded);
+        for (int i = 0; i < userCount; ++i) {
+            bench.addUser(std::make_shared<Student>("Студент_" + std::to_string(i), i, i % 10, "Т.РИ23"));
+        }
+        bench.addResource(std::make_shared<Resource>("Библиотека ДГТУ", 1));
+        bench.closeJournal();
+
+        const int groupedCount = 1000000;
+        auto start = std::chrono::steady_clock::now();
+        mutate(bench, groupedCount);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Без журнала: " << static_cast<long long>(groupedCount / (ms / 1000))
+                  << " изменений/с" << std::endl;
+
+        const int syncedCount = 2000;
+        JournalOptions everyRecord = unbounded;
+        everyRecord.groupCommitRecords = 1;
+        bench.openJournal(snapshotFile, journalFile, everyRecord);
+        start = std::chrono::steady_clock::now();
+        mutate(bench, syncedCount);
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "fsync на каждую запись: " << static_cast<long long>(syncedCount / (ms / 1000))
+                  << " изменений/с" << std::endl;
+
+        bench.openJournal(snapshotFile, journalFile, unbounded);
+        start = std::chrono::steady_clock::now();
+        mutate(bench, groupedCount);
+        bench.commitJournal();
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Групповая фиксация: " << static_cast<long long>(groupedCount / (ms / 1000))
+                  << " изменений/с" << std::endl;
+    }
+
+    {
+        AccessControlSystem<User, Resource> bench;
+        JournalStats stats = bench.openJournal(snapshotFile, journalFile, unbounded);
+        std::cout << "Восстановление из журнала: " << stats.replayedRecords << " записей за "
+                  << stats.recoveryMs << " мс" << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        bench.compactJournal();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Сжатие журнала в снимок: " << ms << " мс" << std::endl;
+    }
+
+    {
+        AccessControlSystem<User, Resource> bench;
+        JournalStats stats = bench.openJournal(snapshotFile, journalFile, unbounded);
+        std::cout << "Восстановление из снимка после сжатия: " << stats.replayedRecords << " записей, "
+                  << bench.getUsers().size() << " польз. за " << stats.recoveryMs << " мс" << std::endl;
+    }
+    removeFiles();
+}
+
+// Benchmark: access rules evaluated per check against the compiled
+// permission matrix, and the cost of its incremental updates
+void benchmarkAccessPolicy() {
+    const int userCount = 200000;
+    const int resourceCount = 1000;
+    const int checks = 1000000;
+    std::mt19937 gen(42);
+    AccessControlSystem<User, Resource> bench;
+    for (int i = 0; i < userCount; ++i) {
+        int level = static_cast<int>(gen() % 6);
+        if (i % 10 < 7) {
+            bench.addUser(std::make_shared<Student>("Студент " + std::to_string(i), i, level,
+                                                    "Группа " + std::to_string(gen() % 50)));
+        } else if (i % 10 < 9) {
+            bench.addUser(std::make_shared<Teacher>("Преподаватель " + std::to_string(i), i, level,
+                                                    "Кафедра " + std::to_string(gen() % 20)));
+        } else {
+            bench.addUser(std::make_shared<Administrator>("Администратор " + std::to_string(i), i, level,
+                                                          static_cast<int>(gen() % 4)));
+        }
+    }
+    for (int i = 0; i < resourceCount; ++i) {
+        bench.addResource(std::make_shared<Resource>("Ресурс " + std::to_string(i), 3 + i % 4));
+    }
+
+    AccessPolicy policy;
+    for (int group = 0; group < 50; ++group) {
+        for (int i = 0; i < 20; ++i) {
+            policy.grantGroup("Группа " + std::to_string(group), "Ресурс " + std::to_string(gen() % resourceCount));
+        }
+    }
+    for (int department = 0; department < 20; ++department) {
+        for (int i = 0; i < 30; ++i) {
+            policy.grantDepartment("Кафедра " + std::to_string(department), "Ресурс " + std::to_string(gen() % resourceCount));
+        }
+    }
+    for (int i = 0; i < resourceCount; i += 10) {
+        policy.setAdminOverride("Ресурс " + std::to_string(i), 2);
+    }
+
+    std::vector<int> userIds(checks), resourceIds(checks);
+    for (int i = 0; i < checks; ++i) {
+        userIds[i] = static_cast<int>(gen() % userCount);
+        resourceIds[i] = static_cast<int>(gen() % resourceCount);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    long long interpreted = 0;
+    for (int i = 0; i < checks; ++i) {
+        interpreted += policy.allows(*bench.searchUserById(userIds[i]), *bench.getResources()[resourceIds[i]]);
+    }
+    double interpretedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / checks;
+
+    start = std::chrono::steady_clock::now();
+    bench.setAccessPolicy(policy);
+    double compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Компиляция политики: " << compileMs << " мс, классов: " << bench.accessPolicy()->classCount()
+              << ", матрица: " << bench.accessPolicy()->matrixBytes() / 1024 << " КБ" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    long long compiled = 0;
+    for (int i = 0; i < checks; ++i) {
+        compiled += bench.checkUserAccessToResource(userIds[i], resourceIds[i]);
+    }
+    double compiledNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / checks;
+
+    AccessBatchResult result;
+    start = std::chrono::steady_clock::now();
+    bench.checkAccessBatch(userIds.data(), resourceIds.data(), checks, result);
+    double batchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / checks;
+    long long batched = 0;
+    for (int i = 0; i < checks; ++i) {
+        batched += result.isGranted(i);
+    }
+
+    std::cout << "Правила по цепочке вызовов: " << interpretedNs << " нс/проверка" << std::endl;
+    std::cout << "Матрица: " << compiledNs << " нс/проверка, пакетом: " << batchNs << " нс/проверка" << std::endl;
+    std::cout << "Разрешено: " << interpreted << " / " << compiled << " / " << batched << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; ++i) {
+        bench.grantGroupAccess("Группа " + std::to_string(gen() % 50), "Ресурс " + std::to_string(gen() % resourceCount));
+    }
+    std::cout << "1000 изменений правил: "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " мс" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100000; ++i) {
+        bench.getUsers()[gen() % userCount]->setAccessLevel(static_cast<int>(gen() % 6));
+    }
+    std::cout << "100000 изменений уровня с переклассификацией: "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " мс" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; ++i) {
+        bench.addResource(std::make_shared<Resource>("Новый ресурс " + std::to_string(i), i % 6));
+    }
+    std::cout << "100 новых ресурсов: "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " мс" << std::endl;
+}
+
+// Benchmark: memory of interned groups, departments and resource names
+// against one std::string per field, and string against symbol comparisons
+void benchmarkSymbols() {
+    const int userCount = 1000000;
+    const int resourceCount = 1000;
+    const int checks = 1000000;
+    std::mt19937 gen(42);
+    AccessControlSystem<User, Resource> bench;
+    size_t symbolsBefore = SymbolTable::global().size();
+    for (int i = 0; i < userCount; ++i) {
+        if (i % 2) {
+            bench.addUser(std::make_shared<Student>("Студент " + std::to_string(i), i, i % 6,
+                                                    "Группа информатики " + std::to_string(gen() % 300)));
+        } else {
+            bench.addUser(std::make_shared<Teacher>("Преподаватель " + std::to_string(i), i, i % 6,
+                                                    "Кафедра прикладной математики " + std::to_string(gen() % 100)));
+        }
+    }
+    for (int i = 0; i < resourceCount; ++i) {
+        bench.addResource(std::make_shared<Resource>("Ресурс лаборатории " + std::to_string(i), i % 6));
+    }
+
+    // What the same fields cost as separate std::string copies
+    size_t perFieldBytes = 0;
+    for (const auto& user : bench.getUsers()) {
+        const std::string& field = user->getKind() == UserKind::Student
+            ? static_cast<const Student&>(*user).getGroup()
+            : static_cast<const Teacher&>(*user).getDepartment();
+        perFieldBytes += sizeof(std::string) + stringHeapBytes(field);
+    }
+    for (const auto& resource : bench.getResources()) {
+        perFieldBytes += sizeof(std::string) + stringHeapBytes(resource->getName());
+    }
+    size_t symbolBytes = (bench.getUsers().size() + bench.getResources().size()) * sizeof(Symbol);
+    std::cout << "Поля строками: " << perFieldBytes / 1024 << " КБ, символами: " << symbolBytes / 1024
+              << " КБ + таблица " << SymbolTable::global().memoryUsage() / 1024 << " КБ ("
+              << SymbolTable::global().size() - symbolsBefore << " новых символов)" << std::endl;
+
+    const Student& sample = static_cast<const Student&>(*bench.getUsers()[1]);
+    const std::string targetGroup = sample.getGroup();
+    const Symbol targetSymbol = sample.getGroupSymbol();
+    auto start = std::chrono::steady_clock::now();
+    size_t byString = 0;
+    for (const auto& user : bench.getUsers()) {
+        byString += user->getKind() == UserKind::Student &&
+                    static_cast<const Student&>(*user).getGroup() == targetGroup;
+    }
+    double stringNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / userCount;
+    start = std::chrono::steady_clock::now();
+    size_t bySymbol = 0;
+    for (const auto& user : bench.getUsers()) {
+        bySymbol += user->getKind() == UserKind::Student &&
+                    static_cast<const Student&>(*user).getGroupSymbol() == targetSymbol;
+    }
+    double symbolNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / userCount;
+    std::cout << "Фильтр по группе: строки " << stringNs << " нс/польз., символы " << symbolNs
+              << " нс/польз. (" << byString << " / " << bySymbol << ")" << std::endl;
+
+    std::vector<int> userIds(checks);
+    std::vector<std::string> names(checks);
+    std::vector<Symbol> symbols(checks);
+    for (int i = 0; i < checks; ++i) {
+        userIds[i] = static_cast<int>(gen() % userCount);
+        names[i] = "Ресурс лаборатории " + std::to_string(gen() % resourceCount);
+        symbols[i] = SymbolTable::global().intern(names[i]);
+    }
+    start = std::chrono::steady_clock::now();
+    long long granted = 0;
+    for (int i = 0; i < checks; ++i) {
+        granted += bench.checkUserAccessToResource(userIds[i], names[i]);
+    }
+    stringNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / checks;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < checks; ++i) {
+        granted -= bench.checkUserAccessToResource(userIds[i], symbols[i]);
+    }
+    symbolNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / checks;
+    std::cout << "Проверка доступа: по имени " << stringNs << " нс, по символу " << symbolNs
+              << " нс (расхождений: " << granted << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    setlocale (LC_ALL, "Russian");
+    if (argc > 1 && std::string(argv[1]) == "--daemon") {
+        return runDaemon(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--client") {
+        return runLoadClient(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        return runBatch(argc, argv);
+    }
+    try {
+        AccessControlSystem<User, Resource> system;
+
+        // Add users
+        system.addUser(std::make_shared<Student>("Андрей Андреев", 1, 2, "Т.РИ23"));
+        system.addUser(std::make_shared<Student>("Максим Минимумов", 2, 2, "Т.РИ22"));
+        system.addUser(std::make_shared<Teacher>("Подколзина Любовь Александровна", 3, 3, "Т-Университет"));
+        system.addUser(std::make_shared<Administrator>("Михалёва Алина Викторовна", 4, 5, 1));
+
+        // Add resources
+        system.addResource(std::make_shared<Resource>("Библиотека ДГТУ", 1));
+        system.addResource(std::make_shared<Resource>("Материалы лаборатории", 3));
+        system.addResource(std::make_shared<Resource>("Панель администратора", 5));
+
+        bool running = true;
+        while (running) {
+            std::cout << "\nВыберите действие:\n";
+            std::cout << "1. Показать пользователей\n";
+            std::cout << "2. Показать ресурсы\n";
+            std::cout << "3. Проверить доступ пользователя к ресурсу\n";
+            std::cout << "4. Поиск пользователей по имени\n";
+            std::cout << "5. Сортировать пользователей по уровню доступа\n";
+            std::cout << "6. Сохранить данные в файлы\n";
+            std::cout << "7. Загрузить данные из файлов\n";
+            std::cout << "8. Выход\n";
+            std::cout << "9. Сохранить двоичный снимок\n";
+            std::cout << "10. Загрузить двоичный снимок\n";
+            std::cout << "11. Пользователи с доступом к ресурсу\n";
+            std::cout << "12. Бенчмарки\n";
+            std::cout << "Введите выбор: ";
+
+            int choice;
+            std::cin >> choice;
+
+            switch (choice) {
+                case 1: {
+                    system.displayUsers();
+                    break;
+                }
+                case 2: {
+                    system.displayResources();
+                    break;
+                }
+                case 3: {
+                    std::cout << "Введите ID пользователя: ";
+                    int userId;
+                    std::cin >> userId;
+                    std::cout << "Введите имя ресурса: ";
+                    std::string resourceName;
+                    std::cin.ignore();
+                    std::getline(std::cin, resourceName);
+                    try {
+                        bool hasAccess = system.checkUserAccessToResource(userId, resourceName);
+                        std::cout << "Пользователь с ID " << userId << (hasAccess ? " имеет " : " не имеет ") << "доступ к " << resourceName << std::endl;
+                    } catch (const std::exception& e) {
+                        std::cout << "Ошибка: " << e.what() << std::endl;
+                    }
+                    break;
+                }
+                case 4: {
+                    std::cout << "Введите имя для поиска: ";
+                    std::string searchName;
+                    std::cin.ignore();
+                    std::getline(std::cin, searchName);
+                    auto foundUsers = system.findUsersByTokens(searchName);
+                    std::cout << "Результаты поиска пользователей с именем \"" << searchName << "\":" << std::endl;
+                    for (size_t i = 0; i < foundUsers.size(); ++i) {
+                        foundUsers[i].displayInfo();
+                    }
+                    break;
+                }
+                case 5: {
+                    system.sortUsersByAccessLevel();
+                    std::cout << "Пользователи отсортированы по уровню доступа:" << std::endl;
+                    system.displayUsers();
+                    break;
+                }
+                case 6: {
+                    std::cout << "Введите имя файла для данных пользователей: ";
+                    std::string usersFile;
+                    std::cin >> usersFile;
+                    std::cout << "Введите имя файла для данных ресурсов: ";
+                    std::string resourcesFile;
+                    std::cin >> resourcesFile;
+                    try {
+                        system.saveToFile(usersFile, resourcesFile);
+                        std::cout << "Данные сохранены в файлы." << std::endl;
+                    } catch (const std::exception& e) {
+                        std::cout << "Ошибка при сохранении данных: " << e.what() << std::endl;
+                    }
+                    break;
+                }
+                case 7: {
+                    std::cout << "Введите имя файла для данных пользователей: ";
+                    std::string usersFile;
+                    std::cin >> usersFile;
+                    std::cout << "Введите имя файла для данных ресурсов: ";
+                    std::string resourcesFile;
+                    std::cin >> resourcesFile;
+                    try {
+                        system.loadFromFile(usersFile, resourcesFile);
+                        std::cout << "Данные загружены из файлов:" << std::endl;
+                        system.displayUsers();
+                        system.displayResources();
+                    } catch (const std::exception& e) {
+                        std::cout << "Ошибка при загрузке данных: " << e.what() << std::endl;
+                    }
+                    break;
+                }
+                case 8: {
+                    running = false;
+                    std::cout << "Выход из системы. До свидания!" << std::endl;
+                    break;
+                }
+                case 9: {
+                    std::cout << "Введите имя файла снимка: ";
+                    std::string snapshotFile;
+                    std::cin >> snapshotFile;
+                    try {
+                        system.saveSnapshot(snapshotFile);
+                        std::cout << "Снимок сохранён." << std::endl;
+                    } catch (const std::exception& e) {
+                        std::cout << "Ошибка при сохранении снимка: " << e.what() << std::endl;
+                    }
+                    break;
+                }
+                case 10: {
+                    std::cout << "Введите имя файла снимка: ";
+                    std::string snapshotFile;
+                    std::cin >> snapshotFile;
+                    try {
+                        system.loadSnapshot(snapshotFile);
+                        std::cout << "Данные загружены из снимка:" << std::endl;
+                        system.displayUsers();
+                        system.displayResources();
+                    } catch (const std::exception& e) {
+                        std::cout << "Ошибка при загрузке снимка: " << e.what() << std::endl;
+                    }
+                    break;
+                }
+                case 11: {
+                    std::cout << "Введите имя ресурса: ";
+                    std::string resourceName;
+                    std::cin.ignore();
+                    std::getline(std::cin, resourceName);
+                    int resourceId = system.findResourceId(resourceName);
+                    if (resourceId < 0) {
+                        std::cout << "Ошибка: Ресурс не найден" << std::endl;
+                        break;
+                    }
+                    int requiredLevel = system.getResources()[resourceId]->getRequiredAccessLevel();
+                    std::cout << "Доступ к " << resourceName << " имеют пользователей: "
+                              << system.countUsersWithLevelAtLeast(requiredLevel) << std::endl;
+                    const size_t pageSize = 20;
+                    AccessLevelCursor cursor;
+                    while (true) {
+                        auto page = system.usersWithLevelAtLeastPage(requiredLevel, cursor, pageSize);
+                        for (size_t i = 0; i < page.size(); ++i) {
+                            page[i].displayInfo();
+                        }
+                        if (cursor.finished) {
+                            break;
+                        }
+                        std::cout << "Показать ещё? (1 - да, 0 - нет): ";
+                        int more;
+                        std::cin >> more;
+                        if (more != 1) {
+                            break;
+                        }
+                    }
+                    break;
+                }
+                case 12: {
+                    std::cout << "1. Задержка проверки доступа\n";
+                    std::cout << "2. Пакетная проверка доступа\n";
+                    std::cout << "3. Загрузка: текст и двоичный снимок\n";
+                    std::cout << "4. Параллельная загрузка текстовых файлов\n";
+                    std::cout << "5. Конкурентное чтение при фоновой записи\n";
+                    std::cout << "6. Поиск по имени\n";
+                    std::cout << "7. Кэш решений о доступе\n";
+                    std::cout << "8. Индекс по уровню доступа\n";
+                    std::cout << "9. Журнал изменений и восстановление\n";
+                    std::cout << "10. Скомпилированная политика доступа\n";
+                    std::cout << "11. Интернирование строк\n";
+                    std::cout << "12. Память: shared_ptr и арена\n";
+                    std::cout << "Введите выбор: ";
+                    int benchChoice;
+                    std::cin >> benchChoice;
+                    switch (benchChoice) {
+                        case 1:
+                            benchmarkAccessChecks();
+                            break;
+                        case 2:
+                            benchmarkBatchChecks();
+                            break;
+                        case 3:
+                            benchmarkSnapshotLoad();
+                            break;
+                        case 4:
+                            benchmarkParallelLoad();
+                            break;
+                        case 5:
+                            benchmarkConcurrentReads();
+                            break;
+                        case 6:
+                            benchmarkNameSearch();
+                            break;
+                        case 7:
+                            benchmarkDecisionCache();
+                            break;
+                        case 8:
+                            benchmarkLevelIndex();
+                            break;
+                        case 9:
+                            benchmarkJournal();
+                            break;
+                        case 10:
+                            benchmarkAccessPolicy();
+                            break;
+                        case 11:
+                            benchmarkSymbols();
+                            break;
+                        case 12:
+                            benchmarkUserStorage();
+                            break;
+                        default:
+                            std::cout << "Неверный выбор." << std::endl;
+                            break;
+                    }
+                    break;
+                }
+                default: {
+                    std::cout << "Неверный выбор. Пожалуйста, попробуйте снова." << std::endl;
+                    break;
+                }
+            }
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Исключение: " << e.what() << std::endl;
+    }
+
+    return 0;
+}
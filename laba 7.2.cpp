@@ -1,214 +1,769 @@
-#include <iostream>
-#include <thread>
-#include <mutex>
-#include <vector>
-#include <chrono>
-#include <cstdlib>
-#include <random>
-#include <string>
-
-using namespace std;
-
-// Класс персонажа
-class Character {
-private:
-    string name;
-    int health;
-    int attack;
-    int defense;
-    mutex mtx;
-
-public:
-    Character(const string& name, int health, int attack, int defense)
-        : name(name), health(health), attack(attack), defense(defense) {}
-
-    void takeDamage(int damage) {
-        lock_guard<mutex> lock(mtx);
-        int actualDamage = max(1, damage - defense);
-        health -= actualDamage;
-        if (health < 0) health = 0;
-    }
-
-    bool isAlive() const {
-        lock_guard<mutex> lock(mtx);
-        return health > 0;
-    }
-
-    int getAttack() const {
-        lock_guard<mutex> lock(mtx);
-        return attack;
-    }
-
-    void displayInfo() const {
-        lock_guard<mutex> lock(mtx);
-        cout << name << " - Health: " << health << ", Attack: " << attack << ", Defense: " << defense << endl;
-    }
-
-    string getName() const {
-        return name;
-    }
-
-    int getHealth() const {
-        lock_guard<mutex> lock(mtx);
-        return health;
-    }
-};
-
-// Класс монстра
-class Monster {
-private:
-    string name;
-    int health;
-    int attack;
-    int defense;
-    mutex mtx;
-
-public:
-    Monster(const string& name, int health, int attack, int defense)
-        : name(name), health(health), attack(attack), defense(defense) {}
-
-    void takeDamage(int damage) {
-        lock_guard<mutex> lock(mtx);
-        int actualDamage = max(1, damage - defense);
-        health -= actualDamage;
-        if (health < 0) health = 0;
-    }
-
-    bool isAlive() const {
-        lock_guard<mutex> lock(mtx);
-        return health > 0;
-    }
-
-    int getAttack() const {
-        lock_guard<mutex> lock(mtx);
-        return attack;
-    }
-
-    void displayInfo() const {
-        lock_guard<mutex> lock(mtx);
-        cout << name << " - Health: " << health << ", Attack: " << attack << ", Defense: " << defense << endl;
-    }
-
-    string getName() const {
-        return name;
-    }
-
-    int getHealth() const {
-        lock_guard<mutex> lock(mtx);
-        return health;
-    }
-};
-
-// Глобальные переменные для хранения монстров
-vector<Monster> monsters;
-mutex monstersMutex;
-
-// Функция для генерации случайных монстров
-void generateMonsters() {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> healthDist(30, 100);
-    uniform_int_distribution<> attackDist(5, 20);
-    uniform_int_distribution<> defenseDist(1, 10);
-    vector<string> names = {"Goblin", "Orc", "Troll", "Skeleton", "Zombie", "Dragon"};
-
-    while (true) {
-        this_thread::sleep_for(chrono::seconds(3)); // Новый монстр каждые 3 секунды
-
-        uniform_int_distribution<> nameDist(0, names.size() - 1);
-        string name = names[nameDist(gen)];
-        int health = healthDist(gen);
-        int attack = attackDist(gen);
-        int defense = defenseDist(gen);
-
-        lock_guard<mutex> lock(monstersMutex);
-        monsters.emplace_back(name, health, attack, defense);
-        cout << "New monster generated: " << name << " (HP: " << health 
-             << ", ATK: " << attack << ", DEF: " << defense << ")\n";
-    }
-}
-
-// Функция для боя между персонажем и монстром
-void battle(Character& hero, Monster& monster) {
-    while (hero.isAlive() && monster.isAlive()) {
-        // Персонаж атакует монстра
-        monster.takeDamage(hero.getAttack());
-        cout << hero.getName() << " attacks " << monster.getName() << "!\n";
-        
-        // Проверяем, жив ли еще монстр
-        if (!monster.isAlive()) {
-            cout << monster.getName() << " has been defeated!\n";
-            break;
-        }
-
-        // Монстр атакует персонажа
-        hero.takeDamage(monster.getAttack());
-        cout << monster.getName() << " attacks " << hero.getName() << "!\n";
-
-        // Выводим текущее состояние
-        hero.displayInfo();
-        monster.displayInfo();
-        cout << "----------------------\n";
-
-        // Пауза между раундами боя
-        this_thread::sleep_for(chrono::seconds(1));
-    }
-
-    if (hero.isAlive()) {
-        cout << hero.getName() << " won the battle!\n";
-    } else {
-        cout << hero.getName() << " has been defeated by " << monster.getName() << "!\n";
-    }
-}
-
-int main() {
-    // Создаем персонажа
-    Character hero("Hero", 100, 15, 5);
-    cout << "Hero created:\n";
-    hero.displayInfo();
-    cout << endl;
-
-    // Запускаем генератор монстров в отдельном потоке
-    thread monsterGenerator(generateMonsters);
-    monsterGenerator.detach();
-
-    // Основной игровой цикл
-    while (hero.isAlive()) {
-        this_thread::sleep_for(chrono::seconds(1));
-
-        // Проверяем наличие монстров
-        monstersMutex.lock();
-        if (!monsters.empty()) {
-            // Берем первого монстра из списка
-            Monster& currentMonster = monsters.front();
-            monstersMutex.unlock();
-
-            cout << "\n=== BATTLE START ===\n";
-            cout << hero.getName() << " vs " << currentMonster.getName() << "\n";
-            hero.displayInfo();
-            currentMonster.displayInfo();
-            cout << "----------------------\n";
-
-            // Запускаем бой в отдельном потоке
-            thread fight(battle, ref(hero), ref(currentMonster));
-            fight.join();
-
-            // Удаляем побежденного монстра
-            monstersMutex.lock();
-            if (!monsters.empty() && !monsters.front().isAlive()) {
-                monsters.erase(monsters.begin());
-            }
-            monstersMutex.unlock();
-
-            if (!hero.isAlive()) {
-                break;
-            }
-        } else {
-            monstersMutex.unlock();
-            cout << "No monsters to fight. Waiting...\n";
-        }
-    }
-
-    cout << "\nGame over!\n";
-    return 0;
-}
\ No newline at end of file
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+using namespace std;
+
+// Уменьшает здоровье через compare-and-swap, не опуская ниже нуля.
+// Возвращает true ровно для одного удара - того, который довел здоровье до нуля.
+inline bool applyDamage(atomic<int>& health, int damage) {
+    int current = health.load(memory_order_relaxed);
+    int next;
+    do {
+        if (current == 0) {
+            return false;
+        }
+        next = max(0, current - damage);
+    } while (!health.compare_exchange_weak(current, next, memory_order_acq_rel, memory_order_relaxed));
+    return next == 0;
+}
+
+// Класс персонажа
+class Character {
+private:
+    // Имя, атака и защита не меняются после создания и читаются без
+    // синхронизации; изменяемо только здоровье
+    string name;
+    atomic<int> health;
+    int attack;
+    int defense;
+
+public:
+    Character(const string& name, int health, int attack, int defense)
+        : name(name), health(health), attack(attack), defense(defense) {}
+
+    // Перемещать можно только объект, с которым не работают другие потоки
+    Character(Character&& other) noexcept
+        : name(move(other.name)), health(other.health.load(memory_order_relaxed)),
+          attack(other.attack), defense(other.defense) {}
+
+    Character& operator=(Character&& other) noexcept {
+        name = move(other.name);
+        health.store(other.health.load(memory_order_relaxed), memory_order_relaxed);
+        attack = other.attack;
+        defense = other.defense;
+        return *this;
+    }
+
+    // true, если именно этот удар убил
+    bool takeDamage(int damage) {
+        return applyDamage(health, max(1, damage - defense));
+    }
+
+    bool isAlive() const {
+        return health.load(memory_order_acquire) > 0;
+    }
+
+    int getAttack() const {
+        return attack;
+    }
+
+    int getDefense() const {
+        return defense;
+    }
+
+    void displayInfo() const {
+        cout << name << " - Health: " << getHealth() << ", Attack: " << attack << ", Defense: " << defense << endl;
+    }
+
+    const string& getName() const {
+        return name;
+    }
+
+    int getHealth() const {
+        return health.load(memory_order_acquire);
+    }
+};
+
+// Класс монстра
+class Monster {
+private:
+    // Имя, атака и защита не меняются после создания и читаются без
+    // синхронизации; изменяемо только здоровье
+    string name;
+    atomic<int> health;
+    int attack;
+    int defense;
+
+public:
+    Monster(const string& name, int health, int attack, int defense)
+        : name(name), health(health), attack(attack), defense(defense) {}
+
+    // Перемещать можно только объект, с которым не работают другие потоки
+    Monster(Monster&& other) noexcept
+        : name(move(other.name)), health(other.health.load(memory_order_relaxed)),
+          attack(other.attack), defense(other.defense) {}
+
+    Monster& operator=(Monster&& other) noexcept {
+        name = move(other.name);
+        health.store(other.health.load(memory_order_relaxed), memory_order_relaxed);
+        attack = other.attack;
+        defense = other.defense;
+        return *this;
+    }
+
+    // true, если именно этот удар убил
+    bool takeDamage(int damage) {
+        return applyDamage(health, max(1, damage - defense));
+    }
+
+    bool isAlive() const {
+        return health.load(memory_order_acquire) > 0;
+    }
+
+    int getAttack() const {
+        return attack;
+    }
+
+    int getDefense() const {
+        return defense;
+    }
+
+    void displayInfo() const {
+        cout << name << " - Health: " << getHealth() << ", Attack: " << attack << ", Defense: " << defense << endl;
+    }
+
+    const string& getName() const {
+        return name;
+    }
+
+    int getHealth() const {
+        return health.load(memory_order_acquire);
+    }
+};
+
+// Ограниченная очередь для нескольких производителей и потребителей.
+// Потоки ждут на условных переменных: pop() просыпается сразу, как только
+// появляется элемент, push() - как только освобождается место. После close()
+// новые элементы не принимаются, а pop() возвращает false, когда очередь пуста.
+template <typename T>
+class Channel {
+private:
+    mutex mtx;
+    condition_variable notEmpty;
+    condition_variable notFull;
+    deque<T> items;
+    size_t capacity;
+    bool closed = false;
+
+public:
+    explicit Channel(size_t capacity) : capacity(max<size_t>(capacity, 1)) {}
+
+    // Ждет свободного места; false, если канал закрыт
+    bool push(T value) {
+        unique_lock<mutex> lock(mtx);
+        notFull.wait(lock, [this]() { return closed || items.size() < capacity; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(move(value));
+        lock.unlock();
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Не ждет: false, если очередь полна или канал закрыт
+    bool tryPush(T& value) {
+        {
+            lock_guard<mutex> lock(mtx);
+            if (closed || items.size() >= capacity) {
+                return false;
+            }
+            items.push_back(move(value));
+        }
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Ждет элемента; false, если канал закрыт и пуст
+    bool pop(T& value) {
+        unique_lock<mutex> lock(mtx);
+        notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+        if (items.empty()) {
+            return false;
+        }
+        value = move(items.front());
+        items.pop_front();
+        lock.unlock();
+        notFull.notify_one();
+        return true;
+    }
+
+    // Не ждет: false, если очередь пуста
+    bool tryPop(T& value) {
+        {
+            lock_guard<mutex> lock(mtx);
+            if (items.empty()) {
+                return false;
+            }
+            value = move(items.front());
+            items.pop_front();
+        }
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lock(mtx);
+            closed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    size_t size() {
+        lock_guard<mutex> lock(mtx);
+        return items.size();
+    }
+};
+
+// Монстр в канале вместе со временем появления - для измерения задержки.
+// Монстр хранится по значению: в канале он только перемещается
+struct SpawnedMonster {
+    Monster monster{"", 0, 0, 0};
+    chrono::steady_clock::time_point spawnedAt;
+};
+
+// Функция для генерации случайного монстра
+Monster randomMonster(mt19937& gen) {
+    static const vector<string> names = {"Goblin", "Orc", "Troll", "Skeleton", "Zombie", "Dragon"};
+    uniform_int_distribution<> nameDist(0, static_cast<int>(names.size()) - 1);
+    uniform_int_distribution<> healthDist(30, 100);
+    uniform_int_distribution<> attackDist(5, 20);
+    uniform_int_distribution<> defenseDist(1, 10);
+    string name = names[nameDist(gen)];
+    int health = healthDist(gen);
+    int attack = attackDist(gen);
+    int defense = defenseDist(gen);
+    return Monster(name, health, attack, defense);
+}
+
+// Поток, который создает монстров с заданной частотой (монстров в секунду;
+// 0 - без ограничения) и отправляет их в канал. stop() или деструктор
+// прерывают ожидание сразу и дожидаются завершения потока; если поток ждет
+// места в полном канале, его сначала нужно разбудить через channel.close().
+class MonsterSpawner {
+public:
+    // Меньшая частота не имеет смысла (реже одного монстра в 1000 секунд)
+    static constexpr double minRate = 1e-3;
+
+private:
+    // Предел задержки перед преобразованием в целые тики часов: без него
+    // count / rate при малой частоте переполняет steady_clock::duration
+    static constexpr double maxDelaySeconds = 1e9;
+
+    Channel<SpawnedMonster>& channel;
+    double rate;
+    bool verbose;
+    mutex mtx;
+    condition_variable stopRequested;
+    bool stopping = false;
+    atomic<long long> spawned{0};
+    thread worker;
+
+    void run() {
+        random_device rd;
+        mt19937 gen(rd());
+        auto start = chrono::steady_clock::now();
+        for (long long count = 0;; ++count) {
+            if (rate > 0) {
+                // Время появления count-го монстра; ждем его или остановки
+                double delay = min(count / rate, maxDelaySeconds);
+                auto due = start + chrono::duration_cast<chrono::steady_clock::duration>(
+                                       chrono::duration<double>(delay));
+                unique_lock<mutex> lock(mtx);
+                if (stopRequested.wait_until(lock, due, [this]() { return stopping; })) {
+                    return;
+                }
+            } else {
+                lock_guard<mutex> lock(mtx);
+                if (stopping) {
+                    return;
+                }
+            }
+
+            SpawnedMonster next;
+            next.monster = randomMonster(gen);
+            if (verbose) {
+                cout << "New monster generated: " << next.monster.getName() << " (HP: " << next.monster.getHealth()
+                     << ", ATK: " << next.monster.getAttack() << ", DEF: " << next.monster.getDefense() << ")\n";
+            }
+            next.spawnedAt = chrono::steady_clock::now();
+            if (!channel.push(move(next))) {
+                return;
+            }
+            spawned.fetch_add(1, memory_order_relaxed);
+        }
+    }
+
+public:
+    MonsterSpawner(Channel<SpawnedMonster>& channel, double rate, bool verbose = true)
+        : channel(channel), rate(rate), verbose(verbose) {
+        worker = thread(&MonsterSpawner::run, this);
+    }
+
+    ~MonsterSpawner() {
+        stop();
+    }
+
+    MonsterSpawner(const MonsterSpawner&) = delete;
+    MonsterSpawner& operator=(const MonsterSpawner&) = delete;
+
+    // Канал не закрывается: у него может быть несколько производителей
+    void stop() {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        stopRequested.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    long long count() const {
+        return spawned.load();
+    }
+};
+
+// Функция для боя между персонажем и монстром
+// verbose = false: без вывода и пауз между раундами (для массовых боев)
+void battle(Character& hero, Monster& monster, bool verbose = true) {
+    while (hero.isAlive() && monster.isAlive()) {
+        // Персонаж атакует монстра
+        monster.takeDamage(hero.getAttack());
+        if (verbose) {
+            cout << hero.getName() << " attacks " << monster.getName() << "!\n";
+        }
+
+        // Проверяем, жив ли еще монстр
+        if (!monster.isAlive()) {
+            if (verbose) {
+                cout << monster.getName() << " has been defeated!\n";
+            }
+            break;
+        }
+
+        // Монстр атакует персонажа
+        hero.takeDamage(monster.getAttack());
+        if (!verbose) {
+            continue;
+        }
+        cout << monster.getName() << " attacks " << hero.getName() << "!\n";
+
+        // Выводим текущее состояние
+        hero.displayInfo();
+        monster.displayInfo();
+        cout << "----------------------\n";
+
+        // Пауза между раундами боя
+        this_thread::sleep_for(chrono::seconds(1));
+    }
+
+    if (!verbose) {
+        return;
+    }
+    if (hero.isAlive()) {
+        cout << hero.getName() << " won the battle!\n";
+    } else {
+        cout << hero.getName() << " has been defeated by " << monster.getName() << "!\n";
+    }
+}
+
+// Пул потоков с перехватом работы. У каждого рабочего потока своя очередь:
+// он берет задачи с ее конца, а опустевший поток забирает самые старые задачи
+// из начала чужих очередей. Задачи из рабочих потоков попадают в свою
+// очередь, внешние - по кругу. Спящие потоки ждут на условной переменной.
+class BattleScheduler {
+public:
+    using Task = function<void()>;
+
+    struct WorkerStats {
+        long long tasks = 0;
+        long long stolen = 0;
+        double busySeconds = 0;
+    };
+
+private:
+    struct alignas(64) Worker {
+        mutex mtx;
+        deque<Task> tasks;
+        atomic<long long> executed{0};
+        atomic<long long> stolen{0};
+        atomic<long long> busyNanos{0};
+    };
+
+    vector<unique_ptr<Worker>> workers;
+    vector<thread> threads;
+    mutex wakeMutex;
+    condition_variable wake;
+    condition_variable idle;
+    atomic<long long> queued{0};
+    atomic<long long> unfinished{0};
+    atomic<size_t> nextWorker{0};
+    bool stopping = false;
+
+    static thread_local BattleScheduler* currentScheduler;
+    static thread_local size_t currentWorker;
+
+    bool popLocal(size_t index, Task& task) {
+        Worker& worker = *workers[index];
+        lock_guard<mutex> lock(worker.mtx);
+        if (worker.tasks.empty()) {
+            return false;
+        }
+        task = move(worker.tasks.back());
+        worker.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t index, Task& task) {
+        for (size_t i = 1; i < workers.size(); ++i) {
+            Worker& victim = *workers[(index + i) % workers.size()];
+            lock_guard<mutex> lock(victim.mtx);
+            if (!victim.tasks.empty()) {
+                task = move(victim.tasks.front());
+                victim.tasks.pop_front();
+                workers[index]->stolen.fetch_add(1, memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(size_t index) {
+        currentScheduler = this;
+        currentWorker = index;
+        Worker& worker = *workers[index];
+        for (;;) {
+            Task task;
+            if (popLocal(index, task) || steal(index, task)) {
+                queued.fetch_sub(1);
+                auto start = chrono::steady_clock::now();
+                try {
+                    task();
+                } catch (const exception& e) {
+                    cerr << "Battle task failed: " << e.what() << endl;
+                }
+                worker.busyNanos.fetch_add(
+                    chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count(),
+                    memory_order_relaxed);
+                worker.executed.fetch_add(1, memory_order_relaxed);
+                if (unfinished.fetch_sub(1) == 1) {
+                    lock_guard<mutex> lock(wakeMutex);
+                    idle.notify_all();
+                }
+                continue;
+            }
+            unique_lock<mutex> lock(wakeMutex);
+            wake.wait(lock, [this]() { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    // threads = 0: по одному потоку на ядро
+    explicit BattleScheduler(size_t threadCount = 0) {
+        if (threadCount == 0) {
+            threadCount = max(1u, thread::hardware_concurrency());
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back(new Worker());
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            threads.emplace_back(&BattleScheduler::run, this, i);
+        }
+    }
+
+    // Выполняет все уже отправленные задачи и останавливает потоки
+    ~BattleScheduler() {
+        {
+            lock_guard<mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    BattleScheduler(const BattleScheduler&) = delete;
+    BattleScheduler& operator=(const BattleScheduler&) = delete;
+
+    void submit(Task task) {
+        size_t index = currentScheduler == this ? currentWorker
+                                                : nextWorker.fetch_add(1, memory_order_relaxed) % workers.size();
+        unfinished.fetch_add(1);
+        {
+            lock_guard<mutex> lock(workers[index]->mtx);
+            workers[index]->tasks.push_back(move(task));
+        }
+        queued.fetch_add(1);
+        {
+            lock_guard<mutex> lock(wakeMutex);
+        }
+        wake.notify_one();
+    }
+
+    // Ждет, пока не будут выполнены все отправленные задачи
+    void waitIdle() {
+        unique_lock<mutex> lock(wakeMutex);
+        idle.wait(lock, [this]() { return unfinished.load() == 0; });
+    }
+
+    size_t size() const {
+        return workers.size();
+    }
+
+    vector<WorkerStats> stats() const {
+        vector<WorkerStats> result;
+        for (const auto& worker : workers) {
+            WorkerStats s;
+            s.tasks = worker->executed.load();
+            s.stolen = worker->stolen.load();
+            s.busySeconds = worker->busyNanos.load() / 1e9;
+            result.push_back(s);
+        }
+        return result;
+    }
+};
+
+thread_local BattleScheduler* BattleScheduler::currentScheduler = nullptr;
+thread_local size_t BattleScheduler::currentWorker = 0;
+
+// Бенчмарк: пропускная способность канала и задержка от появления монстра
+// до того, как его забрал потребитель, при разной частоте появления
+void benchmarkSpawn() {
+    const int producers = 2;
+    const int consumers = 2;
+    const auto duration = chrono::seconds(1);
+    for (double rate : {1000.0, 100000.0, 0.0}) {
+        Channel<SpawnedMonster> channel(1024);
+        vector<vector<long long>> latencies(consumers);
+        vector<thread> consumerThreads;
+        for (int c = 0; c < consumers; ++c) {
+            consumerThreads.emplace_back([&channel, &latencies, c]() {
+                SpawnedMonster next;
+                while (channel.pop(next)) {
+                    latencies[c].push_back(
+                        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - next.spawnedAt).count());
+                }
+            });
+        }
+        auto start = chrono::steady_clock::now();
+        {
+            vector<unique_ptr<MonsterSpawner>> spawners;
+            for (int p = 0; p < producers; ++p) {
+                spawners.emplace_back(new MonsterSpawner(channel, rate / producers, false));
+            }
+            this_thread::sleep_for(duration);
+            channel.close();
+        }
+        for (auto& consumer : consumerThreads) {
+            consumer.join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        vector<long long> all;
+        for (auto& part : latencies) {
+            all.insert(all.end(), part.begin(), part.end());
+        }
+        sort(all.begin(), all.end());
+        cout << "Rate " << (rate > 0 ? to_string(static_cast<long long>(rate)) + "/s" : string("unlimited"))
+             << ": " << static_cast<long long>(all.size() / seconds) << " monsters/s";
+        if (!all.empty()) {
+            cout << ", latency p50 " << all[all.size() / 2] / 1000.0 << " us, p99 "
+                 << all[all.size() * 99 / 100] / 1000.0 << " us, max " << all.back() / 1000.0 << " us";
+        }
+        cout << endl;
+    }
+}
+
+// Бенчмарк: бои распределяются между героями и идут параллельно в пуле;
+// число потоков удваивается до числа ядер (не меньше 4). Монстры создаются
+// заранее, а задачи берут бои пачками, так что измеряется сам пул, а не
+// генерация монстров и не отправка задач по одной
+void benchmarkBattles() {
+    const int heroCount = 64;
+    const size_t battles = 200000;
+    const size_t chunk = 256;
+    const size_t maxThreads = max<size_t>(4, thread::hardware_concurrency());
+    for (size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        vector<Character> heroes;
+        for (int h = 0; h < heroCount; ++h) {
+            heroes.emplace_back("Hero " + to_string(h), 1000000000, 15, 5);
+        }
+        mt19937 gen(42);
+        vector<Monster> monsters;
+        monsters.reserve(battles);
+        for (size_t b = 0; b < battles; ++b) {
+            monsters.push_back(randomMonster(gen));
+        }
+        BattleScheduler scheduler(threadCount);
+        auto start = chrono::steady_clock::now();
+        for (size_t begin = 0; begin < battles; begin += chunk) {
+            size_t end = min(battles, begin + chunk);
+            scheduler.submit([&heroes, &monsters, begin, end]() {
+                for (size_t b = begin; b < end; ++b) {
+                    battle(heroes[b % heroCount], monsters[b], false);
+                }
+            });
+        }
+        scheduler.waitIdle();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        vector<BattleScheduler::WorkerStats> stats = scheduler.stats();
+        cout << "Workers " << threadCount << ": " << static_cast<long long>(battles / seconds) << " battles/s, utilization";
+        for (const auto& s : stats) {
+            cout << " " << static_cast<int>(100 * s.busySeconds / seconds) << "%";
+        }
+        long long stolen = 0;
+        for (const auto& s : stats) {
+            stolen += s.stolen;
+        }
+        cout << ", stolen " << stolen << endl;
+    }
+}
+
+// Бенчмарк: много потоков бьют одного босса. Здоровье под мьютексом (как
+// было раньше) против compare-and-swap; проверяется, что весь урон учтен
+// и что смертельный удар засчитан ровно один раз.
+void benchmarkBoss() {
+    struct LockedBoss {
+        mutex mtx;
+        int health;
+        int defense;
+
+        bool takeDamage(int damage) {
+            lock_guard<mutex> lock(mtx);
+            if (health == 0) {
+                return false;
+            }
+            health = max(0, health - max(1, damage - defense));
+            return health == 0;
+        }
+    };
+
+    const long long hitsPerThread = 200000;
+    const int damage = 15;
+    const int defense = 5;
+    const size_t maxThreads = max<size_t>(8, thread::hardware_concurrency());
+    for (size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        const int bossHealth = static_cast<int>(threadCount * hitsPerThread * (damage - defense) - 1);
+        double seconds[2];
+        long long kills[2] = {0, 0};
+        for (int mode = 0; mode < 2; ++mode) {
+            LockedBoss locked{{}, bossHealth, defense};
+            vector<Monster> bosses;
+            bosses.emplace_back("Boss", bossHealth, 30, defense);
+            atomic<long long> killingBlows{0};
+            vector<thread> threads;
+            auto start = chrono::steady_clock::now();
+            for (size_t t = 0; t < threadCount; ++t) {
+                threads.emplace_back([&, mode]() {
+                    long long local = 0;
+                    for (long long i = 0; i < hitsPerThread; ++i) {
+                        local += mode == 0 ? locked.takeDamage(damage) : bosses[0].takeDamage(damage);
+                    }
+                    killingBlows.fetch_add(local);
+                });
+            }
+            for (auto& t : threads) {
+                t.join();
+            }
+            seconds[mode] = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            kills[mode] = killingBlows.load();
+            int remaining = mode == 0 ? locked.health : bosses[0].getHealth();
+            if (remaining != 0) {
+                cout << "Boss survived with " << remaining << " HP!" << endl;
+            }
+        }
+        const double hits = static_cast<double>(threadCount * hitsPerThread);
+        cout << "Threads " << threadCount << ": mutex " << static_cast<long long>(hits / seconds[0])
+             << " hits/s, CAS " << static_cast<long long>(hits / seconds[1]) << " hits/s, killing blows "
+             << kills[0] << "/" << kills[1] << endl;
+    }
+}
+
+// Параметры: --spawn-rate R - монстров в секунду (по умолчанию один в 3 секунды),
+// --bench-spawn - измерить пропускную способность и задержку канала,
+// --bench-battles - измерить параллельные бои в пуле потоков,
+// --bench-boss - измерить удары многих потоков по одному боссу
+int main(int argc, char* argv[]) {
+    double spawnRate = 1.0 / 3;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--bench-spawn") {
+            benchmarkSpawn();
+            return 0;
+        } else if (arg == "--bench-battles") {
+            benchmarkBattles();
+            return 0;
+        } else if (arg == "--bench-boss") {
+            benchmarkBoss();
+            return 0;
+        } else if (arg == "--spawn-rate") {
+            // Частота должна быть конечным числом целиком, не меньше minRate
+            char* end = nullptr;
+            spawnRate = i + 1 < argc ? strtod(argv[++i], &end) : 0;
+            if (end == nullptr || end == argv[i] || *end != '\0' || !(spawnRate >= MonsterSpawner::minRate) ||
+                !isfinite(spawnRate)) {
+                cerr << "Invalid --spawn-rate: expected a number of monsters per second of at least "
+                     << MonsterSpawner::minRate << endl;
+                return 2;
+            }
+        }
+    }
+
+    // Создаем персонажа
+    Character hero("Hero", 100, 15, 5);
+    cout << "Hero created:\n";
+    hero.displayInfo();
+    cout << endl;
+
+    // Запускаем генератор монстров в отдельном потоке
+    Channel<SpawnedMonster> channel(16);
+    MonsterSpawner spawner(channel, spawnRate);
+    BattleScheduler scheduler;
+
+    // Основной игровой цикл: ждем монстра, не опрашивая очередь
+    while (hero.isAlive()) {
+        SpawnedMonster next;
+        if (!channel.tryPop(next)) {
+            cout << "No monsters to fight. Waiting...\n";
+            if (!channel.pop(next)) {
+                break;
+            }
+        }
+        Monster& currentMonster = next.monster;
+
+        cout << "\n=== BATTLE START ===\n";
+        cout << hero.getName() << " vs " << currentMonster.getName() << "\n";
+        hero.displayInfo();
+        currentMonster.displayInfo();
+        cout << "----------------------\n";
+
+        // Бой идет в пуле потоков, без создания потока на каждый бой
+        scheduler.submit([&hero, &currentMonster]() { battle(hero, currentMonster); });
+        scheduler.waitIdle();
+    }
+
+    channel.close();
+    spawner.stop();
+    cout << "\nGame over!\n";
+    return 0;
+}
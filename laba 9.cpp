@@ -1,419 +1,2338 @@
-#include <iostream>
-#include <string>
-#include <vector>
-#include <fstream>
-#include <stdexcept>
-
-
-template <typename T>
-class Logger {
-private:
-    std::ofstream logFile;
-public:
-    Logger(const std::string& filename) {
-        logFile.open(filename, std::ios::app);
-        if (!logFile.is_open()) {
-            throw std::runtime_error("Не удалось открыть файл журнала");
-        }
-    }
-    ~Logger() {
-        if (logFile.is_open()) {
-            logFile.close();
-        }
-    }
-    void log(const T& message) {
-        logFile << message << std::endl;
-    }
-};
-
-
-class Character {
-private:
-    std::string name;
-    int health;
-    int attack;
-    int defense;
-    int level;
-    int experience;
-
-public:
-    Character(const std::string& n, int h, int a, int d)
-        : name(n), health(h), attack(a), defense(d), level(1), experience(0) {}
-
-    void attackEnemy(Character& enemy, Logger<std::string>& logger) {
-        int damage = attack - enemy.defense;
-        if (damage > 0) {
-            enemy.takeDamage(damage, logger);
-            logger.log(name + " атакует " + enemy.name + " и наносит " + std::to_string(damage) + " урона!");
-            std::cout << name << " атакует " << enemy.name << " и наносит " << damage << " урона!" << std::endl;
-        } else {
-            logger.log(name + " атакует " + enemy.name + ", но это неэффективно!");
-            std::cout << name << " атакует " << enemy.name << ", но это неэффективно!" << std::endl;
-        }
-    }
-
-    void takeDamage(int damage, Logger<std::string>& logger) {
-        health -= damage;
-        if (health < 0) {
-            health = 0;
-            logger.log(name + " был побежден!");
-            throw std::runtime_error(name + " здоровье упало ниже нуля!");
-        }
-    }
-
-    void heal(int amount, Logger<std::string>& logger) {
-        health += amount;
-        if (health > 100) health = 100;
-        logger.log(name + " восстанавливает " + std::to_string(amount) + " HP!");
-        std::cout << name << " восстанавливает " << amount << " HP!" << std::endl;
-    }
-
-    void gainExperience(int exp, Logger<std::string>& logger) {
-        experience += exp;
-        if (experience >= 100) {
-            level++;
-            experience -= 100;
-            logger.log(name + " повысил уровень до " + std::to_string(level) + "!");
-            std::cout << name << " повысил уровень до " << level << "!" << std::endl;
-        }
-    }
-
-    void displayInfo() const {
-        std::cout << "Имя: " << name << ", HP: " << health
-                  << ", Атака: " << attack << ", Защита: " << defense
-                  << ", Уровень: " << level << ", Опыт: " << experience << std::endl;
-    }
-
-    std::string getName() const {
-        return name;
-    }
-
-    int getHealth() const {
-        return health;
-    }
-
-    int getAttack() const {
-        return attack;
-    }
-
-    int getDefense() const {
-        return defense;
-    }
-
-    int getLevel() const {
-        return level;
-    }
-
-    int getExperience() const {
-        return experience;
-    }
-
-    void setHealth(int h) {
-        if (h < 0) {
-            throw std::invalid_argument("Здоровье не может быть отрицательным!");
-        }
-        health = h;
-    }
-};
-
-
-class Monster {
-protected:
-    std::string name;
-    int health;
-    int attack;
-    int defense;
-
-public:
-    Monster(const std::string& n, int h, int a, int d)
-        : name(n), health(h), attack(a), defense(d) {}
-
-    virtual ~Monster() {}
-
-    virtual void attackEnemy(Character& enemy, Logger<std::string>& logger) {
-        int damage = attack - enemy.getDefense();
-        if (damage > 0) {
-            enemy.setHealth(enemy.getHealth() - damage);
-            logger.log(name + " атакует " + enemy.getName() + " и наносит " + std::to_string(damage) + " урона!");
-            std::cout << name << " атакует " << enemy.getName() << " и наносит " << damage << " урона!" << std::endl;
-        } else {
-            logger.log(name + " атакует " + enemy.getName() + ", но это неэффективно!");
-            std::cout << name << " атакует " << enemy.getName() << ", но это неэффективно!" << std::endl;
-        }
-    }
-
-    virtual void displayInfo() const {
-        std::cout << "Монстр: " << name << ", HP: " << health
-                  << ", Атака: " << attack << ", Защита: " << defense << std::endl;
-    }
-
-    std::string getName() const {
-        return name;
-    }
-
-    int getHealth() const {
-        return health;
-    }
-
-    void setHealth(int h) {
-        if (h < 0) {
-            throw std::invalid_argument("Здоровье не может быть отрицательным!");
-        }
-        health = h;
-    }
-
-    int getAttack() const {
-        return attack;
-    }
-
-    int getDefense() const {
-        return defense;
-    }
-};
-
-
-class Chubaka : public Monster {
-public:
-    Chubaka() : Monster("Чубака", 30, 10, 5) {}
-};
-
-class Dynozavr : public Monster {
-public:
-    Dynozavr() : Monster("Динозавр", 100, 25, 15) {}
-};
-
-class Ork : public Monster {
-public:
-    Ork() : Monster("Орк", 50, 15, 10) {}
-};
-
-
-class Inventory {
-private:
-    std::vector<std::string> items;
-
-public:
-    void addItem(const std::string& item) {
-        items.push_back(item);
-        std::cout << item << " добавлен в инвентарь." << std::endl;
-    }
-
-    void removeItem(const std::string& item) {
-        for (auto it = items.begin(); it != items.end(); ++it) {
-            if (*it == item) {
-                items.erase(it);
-                std::cout << item << " удален из инвентаря." << std::endl;
-                return;
-            }
-        }
-        std::cout << item << " не найден в инвентаре." << std::endl;
-    }
-
-    void displayInventory() const {
-        std::cout << "Инвентарь:" << std::endl;
-        for (const auto& item : items) {
-            std::cout << "- " << item << std::endl;
-        }
-    }
-};
-
-
-class Game {
-private:
-    Character player;
-    Inventory inventory;
-    Logger<std::string> logger;
-
-public:
-    Game(const std::string& playerName)
-        : player(playerName, 100, 20, 10), logger("game_log.txt") {}
-
-    void start() {
-        std::cout << "Добро пожаловать в RPG игру, " << player.getName() << "!" << std::endl;
-        player.displayInfo();
-        inventory.displayInventory();
-    }
-
-    void battle(Monster& monster) {
-        std::cout << "Дикий " << monster.getName() << " появился!" << std::endl;
-        monster.displayInfo();
-
-        while (player.getHealth() > 0 && monster.getHealth() > 0) {
-            try {
-                int damage = player.getAttack() - monster.getDefense();
-                if (damage > 0) {
-                    monster.setHealth(monster.getHealth() - damage);
-                    logger.log(player.getName() + " атакует " + monster.getName() + " и наносит " + std::to_string(damage) + " урона!");
-                    std::cout << player.getName() << " атакует " << monster.getName() << " и наносит " << damage << " урона!" << std::endl;
-                } else {
-                    logger.log(player.getName() + " атакует " + monster.getName() + ", но это неэффективно!");
-                    std::cout << player.getName() << " атакует " << monster.getName() << ", но это неэффективно!" << std::endl;
-                }
-            } catch (const std::exception& e) {
-                std::cout << e.what() << std::endl;
-                break;
-            }
-
-            if (monster.getHealth() <= 0) {
-                std::cout << monster.getName() << " побежден!" << std::endl;
-                player.gainExperience(50, logger);
-                break;
-            }
-
-            try {
-                monster.attackEnemy(player, logger);
-            } catch (const std::exception& e) {
-                std::cout << e.what() << std::endl;
-                break;
-            }
-
-            if (player.getHealth() <= 0) {
-                std::cout << player.getName() << " был побежден! Игра окончена." << std::endl;
-                break;
-            }
-        }
-    }
-
-    void saveGame(const std::string& filename) {
-        std::ofstream saveFile(filename);
-        if (!saveFile) {
-            std::cout << "Не удалось открыть файл сохранения." << std::endl;
-            return;
-        }
-        saveFile << player.getName() << std::endl;
-        saveFile << player.getHealth() << std::endl;
-        saveFile << player.getAttack() << std::endl;
-        saveFile << player.getDefense() << std::endl;
-        saveFile << player.getLevel() << std::endl;
-        saveFile << player.getExperience() << std::endl;
-        std::cout << "Игра сохранена в " << filename << std::endl;
-    }
-
-    void loadGame(const std::string& filename) {
-        std::ifstream loadFile(filename);
-        if (!loadFile) {
-            std::cout << "Не удалось открыть файл сохранения." << std::endl;
-            return;
-        }
-        std::string name;
-        int health, attack, defense, level, experience;
-        loadFile >> name >> health >> attack >> defense >> level >> experience;
-        player = Character(name, health, attack, defense);
-        try {
-            player.setHealth(health);
-        } catch (const std::exception& e) {
-            std::cout << "Ошибка при установке здоровья: " << e.what() << std::endl;
-        }
-        std::cout << "Загружен уровень игрока: " << level << ", опыт: " << experience << std::endl;
-        std::cout << "Игра загружена из " << filename << std::endl;
-    }
-
-    void showInventory() const {
-        inventory.displayInventory();
-    }
-
-    void addItemToInventory(const std::string& item) {
-        inventory.addItem(item);
-    }
-
-    void removeItemFromInventory(const std::string& item) {
-        inventory.removeItem(item);
-    }
-
-    std::string getPlayerName() const {
-        return player.getName();
-    }
-
-    int getPlayerHealth() const {
-        return player.getHealth();
-    }
-};
-
-int main() {
-    try {
-        Game game("Герой");
-        game.start();
-
-        bool running = true;
-        while (running) {
-            std::cout << "\nВыберите действие:\n";
-            std::cout << "1. Сразиться с Чубакой\n";
-            std::cout << "2. Сразиться с Динозавром\n";
-            std::cout << "3. Сразиться с Орком\n";
-            std::cout << "4. Показать инвентарь\n";
-            std::cout << "5. Добавить предмет в инвентарь\n";
-            std::cout << "6. Удалить предмет из инвентаря\n";
-            std::cout << "7. Сохранить игру\n";
-            std::cout << "8. Загрузить игру\n";
-            std::cout << "9. Выйти\n";
-            std::cout << "Введите выбор: ";
-
-            int choice;
-            std::cin >> choice;
-
-            switch (choice) {
-                case 1: {
-                    Chubaka chubaka;
-                    game.battle(chubaka);
-                    break;
-                }
-                case 2: {
-                    Dynozavr dynozavr;
-                    game.battle(dynozavr);
-                    break;
-                }
-                case 3: {
-                    Ork ork;
-                    game.battle(ork);
-                    break;
-                }
-                case 4: {
-                    game.showInventory();
-                    break;
-                }
-                case 5: {
-                    std::cout << "Введите предмет для добавления: ";
-                    std::string item;
-                    std::cin.ignore();
-                    std::getline(std::cin, item);
-                    game.addItemToInventory(item);
-                    break;
-                }
-                case 6: {
-                    std::cout << "Введите предмет для удаления: ";
-                    std::string item;
-                    std::cin.ignore();
-                    std::getline(std::cin, item);
-                    game.removeItemFromInventory(item);
-                    break;
-                }
-                case 7: {
-                    std::cout << "Введите имя файла для сохранения игры: ";
-                    std::string filename;
-                    std::cin >> filename;
-                    game.saveGame(filename);
-                    break;
-                }
-                case 8: {
-                    std::cout << "Введите имя файла для загрузки игры: ";
-                    std::string filename;
-                    std::cin >> filename;
-                    game.loadGame(filename);
-                    break;
-                }
-                case 9: {
-                    running = false;
-                    std::cout << "Выход из игры. До свидания!" << std::endl;
-                    break;
-                }
-                default: {
-                    std::cout << "Неверный выбор. Пожалуйста, попробуйте снова." << std::endl;
-                    break;
-                }
-            }
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "Ошибка: " << e.what() << std::endl;
-    }
-    return 0;
-}
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <chrono>
+#include <map>
+#include <algorithm>
+#include <streambuf>
+#include <sstream>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+#include <charconv>
+#include <limits>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+enum class LogFlushPolicy {
+    Interval,    // flush the file at most once per flush interval
+    EveryBatch   // flush after every batch the writer thread writes
+};
+
+enum class LogOverflowPolicy {
+    Block,  // log() waits for free space in the queue
+    Drop    // log() drops the message and counts it
+};
+
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info,
+    Warning,
+    Error
+};
+
+enum class LogCategory : uint8_t {
+    General = 0,
+    Combat,
+    Progression,
+    Inventory,
+    Persistence,
+    Count
+};
+
+struct LoggerOptions {
+    bool async = false;
+    size_t queueCapacity = 8192;
+    std::chrono::milliseconds flushInterval{50};
+    LogFlushPolicy flushPolicy = LogFlushPolicy::Interval;
+    LogOverflowPolicy overflowPolicy = LogOverflowPolicy::Block;
+    bool binary = false;    // write raw records, to be read with --decode-log
+    // Categories written to their own files instead of the logger's file
+    std::map<LogCategory, std::string> categoryFiles;
+};
+
+
+// Bounded lock-free queue for many producers and one consumer. Every cell
+// has a sequence number that tells whose turn it is: producers claim a
+// position with a CAS and publish the cell by advancing its sequence.
+// Values are written and read in place by the given callbacks.
+template <typename Value>
+class MpscQueue {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        Value value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) size_t dequeuePos = 0;
+
+public:
+    explicit MpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename Fill>
+    bool tryPush(Fill fill) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        fill(cell->value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Called by the consumer only
+    template <typename Consume>
+    bool tryPop(Consume consume) {
+        Cell& cell = cells[dequeuePos & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+            return false;
+        }
+        consume(cell.value);
+        cell.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+        ++dequeuePos;
+        return true;
+    }
+
+    bool empty() const {
+        return cells[dequeuePos & mask].sequence.load(std::memory_order_acquire) != dequeuePos + 1;
+    }
+};
+
+
+// Events of structured log records. A record stores the event and its raw
+// arguments; the text is produced from the format only when the record is
+// written as text by the writer thread or decoded offline (--decode-log).
+enum class LogEvent : uint16_t {
+    Text = 0,
+    Attack,
+    AttackIneffective,
+    Defeated,
+    Heal,
+    LevelUp,
+    ItemAdded,
+    ItemRemoved,
+    GameSaved,
+    GameLoaded,
+    Count
+};
+
+// Compile-time filter: -DLOG_MIN_LEVEL=N removes events below level N and
+// -DLOG_CATEGORIES=MASK keeps only categories whose bit is set. Release
+// builds (NDEBUG) drop hit-by-hit combat records, which are Debug.
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL 1
+#else
+#define LOG_MIN_LEVEL 0
+#endif
+#endif
+#ifndef LOG_CATEGORIES
+#define LOG_CATEGORIES 0xFFu
+#endif
+
+constexpr int minLogLevel = LOG_MIN_LEVEL;
+constexpr unsigned enabledLogCategories = LOG_CATEGORIES;
+
+struct LogEventInfo {
+    const char* format;
+    LogLevel level;
+    LogCategory category;
+};
+
+constexpr LogEventInfo logEventTable[] = {
+    {"{}", LogLevel::Info, LogCategory::General},
+    {"{} атакует {} и наносит {} урона!", LogLevel::Debug, LogCategory::Combat},
+    {"{} атакует {}, но это неэффективно!", LogLevel::Debug, LogCategory::Combat},
+    {"{} был побежден!", LogLevel::Info, LogCategory::Combat},
+    {"{} восстанавливает {} HP!", LogLevel::Debug, LogCategory::Combat},
+    {"{} повысил уровень до {}!", LogLevel::Info, LogCategory::Progression},
+    {"Предмет добавлен в инвентарь: {}", LogLevel::Debug, LogCategory::Inventory},
+    {"Предмет удален из инвентаря: {}", LogLevel::Debug, LogCategory::Inventory},
+    {"Игра сохранена в {}", LogLevel::Info, LogCategory::Persistence},
+    {"Игра загружена из {}", LogLevel::Info, LogCategory::Persistence}
+};
+
+static_assert(sizeof(logEventTable) / sizeof(logEventTable[0]) == static_cast<size_t>(LogEvent::Count),
+              "every log event needs an entry in logEventTable");
+
+constexpr const LogEventInfo& logEventInfo(LogEvent event) {
+    return logEventTable[static_cast<size_t>(event)];
+}
+
+constexpr bool logEventEnabled(LogEvent event) {
+    return static_cast<int>(logEventInfo(event).level) >= minLogLevel &&
+           ((enabledLogCategories >> static_cast<unsigned>(logEventInfo(event).category)) & 1u) != 0;
+}
+
+inline const char* logEventFormat(LogEvent event) {
+    return logEventInfo(event).format;
+}
+
+// Record layout: uint16 event, uint16 payload size, then every argument as
+// a type byte followed by an int32 ('i') or a uint16 length and bytes ('s').
+// Strings are cut to LOG_STRING_LIMIT bytes (at a UTF-8 character boundary),
+// so the payload of a record always fits its uint16 size field.
+const size_t LOG_RECORD_HEADER_SIZE = 4;
+const size_t LOG_STRING_LIMIT = 16384;
+
+inline size_t logStringLength(const std::string& value) {
+    if (value.size() <= LOG_STRING_LIMIT) {
+        return value.size();
+    }
+    size_t length = LOG_STRING_LIMIT;
+    while (length > 0 && (static_cast<unsigned char>(value[length]) & 0xC0) == 0x80) {
+        --length;
+    }
+    return length;
+}
+
+inline size_t logArgumentSize(int) {
+    return 1 + sizeof(int32_t);
+}
+
+inline size_t logArgumentSize(const std::string& value) {
+    return 1 + sizeof(uint16_t) + logStringLength(value);
+}
+
+inline char* encodeLogArgument(char* out, int value) {
+    *out++ = 'i';
+    int32_t raw = value;
+    std::memcpy(out, &raw, sizeof(raw));
+    return out + sizeof(raw);
+}
+
+inline char* encodeLogArgument(char* out, const std::string& value) {
+    *out++ = 's';
+    uint16_t length = static_cast<uint16_t>(logStringLength(value));
+    std::memcpy(out, &length, sizeof(length));
+    std::memcpy(out + sizeof(length), value.data(), length);
+    return out + sizeof(length) + length;
+}
+
+template <typename... Args>
+size_t logRecordSize(const Args&... args) {
+    return LOG_RECORD_HEADER_SIZE + (size_t(0) + ... + logArgumentSize(args));
+}
+
+template <typename... Args>
+void encodeLogRecord(char* out, LogEvent event, const Args&... args) {
+    static_assert(sizeof...(Args) * (1 + sizeof(uint16_t) + LOG_STRING_LIMIT) <= UINT16_MAX,
+                  "too many arguments for the uint16 payload size of a log record");
+    uint16_t id = static_cast<uint16_t>(event);
+    uint16_t payload = static_cast<uint16_t>(logRecordSize(args...) - LOG_RECORD_HEADER_SIZE);
+    std::memcpy(out, &id, sizeof(id));
+    std::memcpy(out + 2, &payload, sizeof(payload));
+    char* pos = out + LOG_RECORD_HEADER_SIZE;
+    ((pos = encodeLogArgument(pos, args)), ...);
+}
+
+// Appends the text of one record; returns false if the record is malformed
+inline bool formatLogRecord(const char* record, size_t size, std::string& out) {
+    uint16_t id, payload;
+    if (size < LOG_RECORD_HEADER_SIZE) {
+        return false;
+    }
+    std::memcpy(&id, record, sizeof(id));
+    std::memcpy(&payload, record + 2, sizeof(payload));
+    if (id >= static_cast<uint16_t>(LogEvent::Count) || size < LOG_RECORD_HEADER_SIZE + payload) {
+        return false;
+    }
+    const char* pos = record + LOG_RECORD_HEADER_SIZE;
+    const char* end = pos + payload;
+    for (const char* format = logEventFormat(static_cast<LogEvent>(id)); *format; ++format) {
+        if (format[0] != '{' || format[1] != '}') {
+            out += *format;
+            continue;
+        }
+        ++format;
+        if (pos < end && *pos == 'i' && end - pos >= 5) {
+            int32_t value;
+            std::memcpy(&value, pos + 1, sizeof(value));
+            out += std::to_string(value);
+            pos += 5;
+        } else if (pos < end && *pos == 's' && end - pos >= 3) {
+            uint16_t length;
+            std::memcpy(&length, pos + 1, sizeof(length));
+            if (end - pos - 3 < length) {
+                return false;
+            }
+            out.append(pos + 3, length);
+            pos += 3 + length;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Queue cell of the asynchronous logger: records up to INLINE_SIZE bytes
+// are copied into the cell, longer ones (long text messages) into a string
+struct LogRecordSlot {
+    static const size_t INLINE_SIZE = 116;
+
+    uint32_t size = 0;
+    uint32_t sink = 0;
+    char inlineData[INLINE_SIZE];
+    std::string overflow;
+
+    char* prepare(size_t recordSize) {
+        size = static_cast<uint32_t>(recordSize);
+        if (recordSize <= INLINE_SIZE) {
+            return inlineData;
+        }
+        overflow.resize(recordSize);
+        return &overflow[0];
+    }
+
+    const char* data() const {
+        return size <= INLINE_SIZE ? inlineData : overflow.data();
+    }
+};
+
+template <typename T>
+class Logger {
+private:
+    // sinks[0] is the logger's own file; sinkOf maps categories to sinks
+    std::vector<std::unique_ptr<std::ofstream>> sinks;
+    uint32_t sinkOf[static_cast<size_t>(LogCategory::Count)] = {};
+    LoggerOptions options;
+
+    // Asynchronous mode: callers copy encoded records into the queue, and the
+    // writer thread formats them into one buffer that is written with a single call
+    std::unique_ptr<MpscQueue<LogRecordSlot>> queue;
+    std::thread writer;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    std::atomic<bool> writerSleeping{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> flushRequested{false};
+    std::atomic<unsigned long long> enqueuedCount{0};
+    std::atomic<unsigned long long> flushedCount{0};
+    std::atomic<unsigned long long> droppedCount{0};
+
+    static std::string format(const T& message) {
+        if constexpr (std::is_convertible<const T&, std::string>::value) {
+            return message;
+        } else {
+            std::ostringstream stream;
+            stream << message;
+            return stream.str();
+        }
+    }
+
+    // Appends a record to the output as text line or as is in binary mode
+    void appendRecord(const char* record, size_t size, std::string& out) const {
+        if (options.binary) {
+            out.append(record, size);
+        } else {
+            if (!formatLogRecord(record, size, out)) {
+                out += "<повреждённая запись>";
+            }
+            out += '\n';
+        }
+    }
+
+    uint32_t openSink(const std::string& filename, std::map<std::string, uint32_t>& opened) {
+        auto found = opened.find(filename);
+        if (found != opened.end()) {
+            return found->second;
+        }
+        std::unique_ptr<std::ofstream> file(new std::ofstream(
+            filename, options.binary ? std::ios::app | std::ios::binary : std::ios::app));
+        if (!file->is_open()) {
+            throw std::runtime_error("Не удалось открыть файл журнала");
+        }
+        sinks.push_back(std::move(file));
+        opened[filename] = static_cast<uint32_t>(sinks.size() - 1);
+        return static_cast<uint32_t>(sinks.size() - 1);
+    }
+
+    template <typename... Args>
+    void write(LogEvent event, const Args&... args) {
+        const size_t size = logRecordSize(args...);
+        const uint32_t sink = sinkOf[static_cast<size_t>(logEventInfo(event).category)];
+        if (!queue) {
+            std::string record(size, '\0');
+            encodeLogRecord(&record[0], event, args...);
+            std::string out;
+            appendRecord(record.data(), size, out);
+            sinks[sink]->write(out.data(), static_cast<std::streamsize>(out.size()));
+            sinks[sink]->flush();
+            return;
+        }
+        auto fill = [&](LogRecordSlot& slot) {
+            slot.sink = sink;
+            encodeLogRecord(slot.prepare(size), event, args...);
+        };
+        while (!queue->tryPush(fill)) {
+            if (options.overflowPolicy == LogOverflowPolicy::Drop) {
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            wakeWriter();
+            std::this_thread::yield();
+        }
+        enqueuedCount.fetch_add(1, std::memory_order_relaxed);
+        wakeWriter();
+    }
+
+    void wakeWriter() {
+        // Pairs with the writer setting writerSleeping before it checks the queue
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writerSleeping.load()) {
+            { std::lock_guard<std::mutex> lock(wakeMutex); }
+            wake.notify_one();
+        }
+    }
+
+    void writerLoop() {
+        const size_t batchLimit = 1 << 16;
+        std::vector<std::string> batches(sinks.size());
+        size_t batched = 0;
+        unsigned long long writtenCount = 0;
+        bool unflushed = false;
+        auto lastFlush = std::chrono::steady_clock::now();
+        auto consume = [this, &batches, &batched](LogRecordSlot& slot) {
+            std::string& batch = batches[slot.sink];
+            const size_t before = batch.size();
+            appendRecord(slot.data(), slot.size, batch);
+            batched += batch.size() - before;
+        };
+        for (;;) {
+            unsigned long long count = 0;
+            while (batched < batchLimit && queue->tryPop(consume)) {
+                ++count;
+            }
+            if (count > 0) {
+                for (size_t i = 0; i < sinks.size(); ++i) {
+                    if (!batches[i].empty()) {
+                        sinks[i]->write(batches[i].data(), static_cast<std::streamsize>(batches[i].size()));
+                        batches[i].clear();
+                    }
+                }
+                batched = 0;
+                writtenCount += count;
+                unflushed = true;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            bool flushNow = flushRequested.exchange(false) || (unflushed && count == 0) ||
+                            (count > 0 && (options.flushPolicy == LogFlushPolicy::EveryBatch ||
+                                           now - lastFlush >= options.flushInterval));
+            if (flushNow) {
+                for (auto& sink : sinks) {
+                    sink->flush();
+                }
+                lastFlush = now;
+                unflushed = false;
+                flushedCount.store(writtenCount);
+                { std::lock_guard<std::mutex> lock(wakeMutex); }
+                flushed.notify_all();
+            }
+            if (count > 0) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            if (stopping.load() && queue->empty()) {
+                break;
+            }
+            writerSleeping.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            wake.wait_for(lock, options.flushInterval, [this]() {
+                return stopping.load() || flushRequested.load() || !queue->empty();
+            });
+            writerSleeping.store(false);
+        }
+    }
+
+public:
+    Logger(const std::string& filename, const LoggerOptions& options = LoggerOptions()) : options(options) {
+        std::map<std::string, uint32_t> opened;
+        openSink(filename, opened);
+        for (const auto& route : options.categoryFiles) {
+            sinkOf[static_cast<size_t>(route.first)] = openSink(route.second, opened);
+        }
+        if (options.async) {
+            queue.reset(new MpscQueue<LogRecordSlot>(options.queueCapacity));
+            writer = std::thread(&Logger::writerLoop, this);
+        }
+    }
+
+    // Everything logged before destruction is written and flushed
+    ~Logger() {
+        if (writer.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                stopping.store(true);
+            }
+            wake.notify_one();
+            writer.join();
+        }
+    }
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    void log(const T& message) {
+        if (!queue && !options.binary) {
+            *sinks[sinkOf[static_cast<size_t>(LogCategory::General)]] << message << std::endl;
+            return;
+        }
+        write(LogEvent::Text, format(message));
+    }
+
+    // Logs a structured record: the arguments (int or std::string) are copied
+    // into the record and formatted later, off the caller's thread. Events
+    // removed by LOG_MIN_LEVEL / LOG_CATEGORIES compile to nothing.
+    template <LogEvent Event, typename... Args>
+    void logEvent(const Args&... args) {
+        if constexpr (logEventEnabled(Event)) {
+            write(Event, args...);
+        } else {
+            ((void)args, ...);
+        }
+    }
+
+    // Waits until everything logged so far is written and flushed
+    void flush() {
+        if (!queue) {
+            for (auto& sink : sinks) {
+                sink->flush();
+            }
+            return;
+        }
+        const unsigned long long target = enqueuedCount.load();
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        flushRequested.store(true);
+        wake.notify_one();
+        flushed.wait(lock, [this, target]() { return flushedCount.load() >= target; });
+    }
+
+    unsigned long long dropped() const {
+        return droppedCount.load();
+    }
+};
+
+
+// Combat core: damage and deaths are plain values, nothing here throws.
+// Health never drops below zero; the throwing methods below wrap these.
+struct HitResult {
+    int damage = 0;         // damage actually dealt, at most the target's health
+    bool defeated = false;  // the target's health reached zero
+};
+
+inline int hitDamage(int attack, int defense) noexcept {
+    return std::max(attack - defense, 0);
+}
+
+inline HitResult applyHit(int& health, int damage) noexcept {
+    HitResult result;
+    result.damage = std::min(damage, health);
+    health -= result.damage;
+    result.defeated = health <= 0;
+    return result;
+}
+
+
+// Monster kinds are shared immutable templates; a live monster is only a
+// template id and its health, so hordes fit in contiguous arrays
+enum class MonsterBehaviour : uint8_t {
+    Melee = 0   // hits back every round with attack minus defense
+};
+
+struct MonsterTemplate {
+    const char* name;
+    int health;
+    int attack;
+    int defense;
+    MonsterBehaviour behaviour;
+};
+
+const uint32_t CHUBAKA_TEMPLATE = 0;
+const uint32_t DYNOZAVR_TEMPLATE = 1;
+const uint32_t ORK_TEMPLATE = 2;
+
+constexpr MonsterTemplate builtinMonsterTemplates[] = {
+    {"Чубака", 30, 10, 5, MonsterBehaviour::Melee},
+    {"Динозавр", 100, 25, 15, MonsterBehaviour::Melee},
+    {"Орк", 50, 15, 10, MonsterBehaviour::Melee}
+};
+
+struct MonsterInstance {
+    uint32_t templateId;
+    int32_t health;
+};
+
+static_assert(sizeof(MonsterInstance) == 8, "MonsterInstance must stay compact");
+
+class MonsterCatalog {
+private:
+    std::vector<MonsterTemplate> templates;
+    std::deque<std::string> names;   // stable storage for template names
+    std::unordered_map<std::string, uint32_t> byName;
+
+    static void checkStats(const std::string& name, int health, int attack, int defense) {
+        if (health <= 0 || attack < 0 || defense < 0) {
+            throw std::invalid_argument("Неверные характеристики монстра: " + name);
+        }
+    }
+
+public:
+    MonsterCatalog() {
+        for (const MonsterTemplate& builtin : builtinMonsterTemplates) {
+            add(builtin.name, builtin.health, builtin.attack, builtin.defense, builtin.behaviour);
+        }
+    }
+
+    MonsterCatalog(const MonsterCatalog&) = delete;
+    MonsterCatalog& operator=(const MonsterCatalog&) = delete;
+
+    // Adds a kind and returns its id. Templates are never changed in place:
+    // re-adding a known name (a rebalance) creates a new id and points the
+    // name at it, so instances spawned from the old id keep their old stats
+    uint32_t add(const std::string& name, int health, int attack, int defense,
+                 MonsterBehaviour behaviour = MonsterBehaviour::Melee) {
+        checkStats(name, health, attack, defense);
+        uint32_t id = static_cast<uint32_t>(templates.size());
+        auto found = byName.find(name);
+        if (found != byName.end()) {
+            templates.push_back({templates[found->second].name, health, attack, defense, behaviour});
+            found->second = id;
+            return id;
+        }
+        names.push_back(name);
+        templates.push_back({names.back().c_str(), health, attack, defense, behaviour});
+        byName.emplace(name, id);
+        return id;
+    }
+
+    // File format: one kind per line, "health attack defense behaviour name";
+    // empty lines and lines starting with # are skipped. The whole file is
+    // parsed before anything is added, so a bad line leaves the catalog as is
+    size_t loadFromFile(const std::string& filename) {
+        std::ifstream file(filename);
+        if (!file) {
+            throw std::runtime_error("Не удалось открыть каталог монстров: " + filename);
+        }
+        struct ParsedKind {
+            std::string name;
+            int health, attack, defense, behaviour;
+        };
+        std::vector<ParsedKind> parsed;
+        std::string line;
+        for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+            size_t begin = line.find_first_not_of(" \t");
+            if (begin == std::string::npos || line[begin] == '#') {
+                continue;
+            }
+            std::istringstream fields(line);
+            int health, attack, defense, behaviour;
+            std::string name;
+            if (!(fields >> health >> attack >> defense >> behaviour) || behaviour != 0 ||
+                !std::getline(fields >> std::ws, name) || name.empty()) {
+                throw std::runtime_error("Неверная строка " + std::to_string(lineNumber) + " в " + filename);
+            }
+            name.erase(name.find_last_not_of(" \t\r") + 1);
+            checkStats(name, health, attack, defense);
+            parsed.push_back({std::move(name), health, attack, defense, behaviour});
+        }
+        for (const ParsedKind& kind : parsed) {
+            add(kind.name, kind.health, kind.attack, kind.defense, static_cast<MonsterBehaviour>(kind.behaviour));
+        }
+        return parsed.size();
+    }
+
+    bool find(const std::string& name, uint32_t& id) const {
+        auto found = byName.find(name);
+        if (found == byName.end()) {
+            return false;
+        }
+        id = found->second;
+        return true;
+    }
+
+    const MonsterTemplate& operator[](uint32_t id) const noexcept {
+        return templates[id];
+    }
+
+    size_t size() const {
+        return templates.size();
+    }
+
+    MonsterInstance spawn(uint32_t id) const noexcept {
+        return {id, templates[id].health};
+    }
+};
+
+struct HordeRoundResult {
+    size_t attacked = 0;
+    size_t killed = 0;
+    long long damageTaken = 0;
+};
+
+// One round of a hero against a horde: the hero hits every live monster,
+// then every survivor hits back according to its behaviour
+inline HordeRoundResult resolveHordeRound(const MonsterCatalog& catalog, std::vector<MonsterInstance>& horde,
+                                          int heroAttack, int heroDefense) noexcept {
+    HordeRoundResult result;
+    for (MonsterInstance& monster : horde) {
+        if (monster.health <= 0) {
+            continue;
+        }
+        const MonsterTemplate& kind = catalog[monster.templateId];
+        int health = monster.health;
+        ++result.attacked;
+        if (applyHit(health, hitDamage(heroAttack, kind.defense)).defeated) {
+            ++result.killed;
+        } else {
+            switch (kind.behaviour) {
+                case MonsterBehaviour::Melee:
+                    result.damageTaken += hitDamage(kind.attack, heroDefense);
+                    break;
+            }
+        }
+        monster.health = health;
+    }
+    return result;
+}
+
+
+class Character {
+private:
+    std::string name;
+    int health;
+    int attack;
+    int defense;
+    int level;
+    int experience;
+
+public:
+    Character(const std::string& n, int h, int a, int d)
+        : name(n), health(h), attack(a), defense(d), level(1), experience(0) {}
+
+    Character(const std::string& n, int h, int a, int d, int l, int e)
+        : name(n), health(h), attack(a), defense(d), level(l), experience(e) {}
+
+    void attackEnemy(Character& enemy, Logger<std::string>& logger) {
+        int damage = attack - enemy.defense;
+        if (damage > 0) {
+            enemy.takeDamage(damage, logger);
+            logger.logEvent<LogEvent::Attack>(name, enemy.name, damage);
+            std::cout << name << " атакует " << enemy.name << " и наносит " << damage << " урона!" << std::endl;
+        } else {
+            logger.logEvent<LogEvent::AttackIneffective>(name, enemy.name);
+            std::cout << name << " атакует " << enemy.name << ", но это неэффективно!" << std::endl;
+        }
+    }
+
+    HitResult receiveHit(int damage) noexcept {
+        return applyHit(health, damage);
+    }
+
+    // Throws if the damage exceeds the remaining health
+    void takeDamage(int damage, Logger<std::string>& logger) {
+        HitResult hit = receiveHit(damage);
+        if (hit.damage < damage) {
+            logger.logEvent<LogEvent::Defeated>(name);
+            throw std::runtime_error(name + " здоровье упало ниже нуля!");
+        }
+    }
+
+    void heal(int amount, Logger<std::string>& logger) {
+        health += amount;
+        if (health > 100) health = 100;
+        logger.logEvent<LogEvent::Heal>(name, amount);
+        std::cout << name << " восстанавливает " << amount << " HP!" << std::endl;
+    }
+
+    void gainExperience(int exp, Logger<std::string>& logger) {
+        experience += exp;
+        if (experience >= 100) {
+            level++;
+            experience -= 100;
+            logger.logEvent<LogEvent::LevelUp>(name, level);
+            std::cout << name << " повысил уровень до " << level << "!" << std::endl;
+        }
+    }
+
+    void displayInfo() const {
+        std::cout << "Имя: " << name << ", HP: " << health
+                  << ", Атака: " << attack << ", Защита: " << defense
+                  << ", Уровень: " << level << ", Опыт: " << experience << std::endl;
+    }
+
+    const std::string& getName() const {
+        return name;
+    }
+
+    int getHealth() const {
+        return health;
+    }
+
+    int getAttack() const {
+        return attack;
+    }
+
+    int getDefense() const {
+        return defense;
+    }
+
+    int getLevel() const {
+        return level;
+    }
+
+    int getExperience() const {
+        return experience;
+    }
+
+    bool trySetHealth(int h) noexcept {
+        if (h < 0) {
+            return false;
+        }
+        health = h;
+        return true;
+    }
+
+    void setHealth(int h) {
+        if (!trySetHealth(h)) {
+            throw std::invalid_argument("Здоровье не может быть отрицательным!");
+        }
+    }
+};
+
+
+class Monster {
+protected:
+    std::string name;
+    int health;
+    int attack;
+    int defense;
+
+public:
+    Monster(const std::string& n, int h, int a, int d)
+        : name(n), health(h), attack(a), defense(d) {}
+
+    explicit Monster(const MonsterTemplate& kind)
+        : Monster(kind.name, kind.health, kind.attack, kind.defense) {}
+
+    virtual ~Monster() {}
+
+    // Attacks without exceptions; the enemy's health stops at zero
+    HitResult strike(Character& enemy, Logger<std::string>& logger) {
+        int damage = hitDamage(attack, enemy.getDefense());
+        if (damage == 0) {
+            logger.logEvent<LogEvent::AttackIneffective>(name, enemy.getName());
+            std::cout << name << " атакует " << enemy.getName() << ", но это неэффективно!" << std::endl;
+            return HitResult();
+        }
+        HitResult hit = enemy.receiveHit(damage);
+        logger.logEvent<LogEvent::Attack>(name, enemy.getName(), damage);
+        std::cout << name << " атакует " << enemy.getName() << " и наносит " << damage << " урона!" << std::endl;
+        if (hit.defeated) {
+            logger.logEvent<LogEvent::Defeated>(enemy.getName());
+        }
+        return hit;
+    }
+
+    // Throws, leaving the enemy untouched, if the damage exceeds its health
+    virtual void attackEnemy(Character& enemy, Logger<std::string>& logger) {
+        if (hitDamage(attack, enemy.getDefense()) > enemy.getHealth()) {
+            throw std::invalid_argument("Здоровье не может быть отрицательным!");
+        }
+        strike(enemy, logger);
+    }
+
+    virtual void displayInfo() const {
+        std::cout << "Монстр: " << name << ", HP: " << health
+                  << ", Атака: " << attack << ", Защита: " << defense << std::endl;
+    }
+
+    const std::string& getName() const {
+        return name;
+    }
+
+    int getHealth() const {
+        return health;
+    }
+
+    HitResult receiveHit(int damage) noexcept {
+        return applyHit(health, damage);
+    }
+
+    bool trySetHealth(int h) noexcept {
+        if (h < 0) {
+            return false;
+        }
+        health = h;
+        return true;
+    }
+
+    void setHealth(int h) {
+        if (!trySetHealth(h)) {
+            throw std::invalid_argument("Здоровье не может быть отрицательным!");
+        }
+    }
+
+    int getAttack() const {
+        return attack;
+    }
+
+    int getDefense() const {
+        return defense;
+    }
+};
+
+
+class Chubaka : public Monster {
+public:
+    Chubaka() : Monster(builtinMonsterTemplates[CHUBAKA_TEMPLATE]) {}
+};
+
+class Dynozavr : public Monster {
+public:
+    Dynozavr() : Monster(builtinMonsterTemplates[DYNOZAVR_TEMPLATE]) {}
+};
+
+class Ork : public Monster {
+public:
+    Ork() : Monster(builtinMonsterTemplates[ORK_TEMPLATE]) {}
+};
+
+
+// Interns item names: the inventory keeps 32-bit ids instead of strings
+class ItemRegistry {
+private:
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> ids;
+
+public:
+    static ItemRegistry& global() {
+        static ItemRegistry registry;
+        return registry;
+    }
+
+    uint32_t intern(const std::string& name) {
+        auto found = ids.find(name);
+        if (found != ids.end()) {
+            return found->second;
+        }
+        names.push_back(name);
+        ids.emplace(name, static_cast<uint32_t>(names.size() - 1));
+        return static_cast<uint32_t>(names.size() - 1);
+    }
+
+    bool find(const std::string& name, uint32_t& id) const {
+        auto found = ids.find(name);
+        if (found == ids.end()) {
+            return false;
+        }
+        id = found->second;
+        return true;
+    }
+
+    const std::string& name(uint32_t id) const {
+        return names[id];
+    }
+};
+
+struct ItemStack {
+    uint32_t item;
+    uint32_t count;
+};
+
+using LootTable = std::vector<ItemStack>;
+
+// Items are stacks in order of acquisition, found through a hash index.
+// An emptied stack stays in place with count 0 until the empty stacks
+// outnumber the live ones, so removal is O(1) amortized and order is stable.
+class Inventory {
+private:
+    std::vector<ItemStack> stacks;
+    std::unordered_map<uint32_t, uint32_t> slotOf;
+    size_t emptyStacks = 0;
+    unsigned long long total = 0;
+
+    void compact() {
+        size_t live = 0;
+        for (const ItemStack& stack : stacks) {
+            if (stack.count > 0) {
+                slotOf[stack.item] = static_cast<uint32_t>(live);
+                stacks[live++] = stack;
+            }
+        }
+        stacks.resize(live);
+        emptyStacks = 0;
+    }
+
+public:
+    // Throws std::overflow_error and changes nothing if the stack would
+    // exceed UINT32_MAX items
+    void add(uint32_t item, uint32_t count = 1) {
+        if (count == 0) {
+            return;
+        }
+        auto inserted = slotOf.emplace(item, static_cast<uint32_t>(stacks.size()));
+        if (inserted.second) {
+            stacks.push_back({item, count});
+        } else {
+            uint32_t& stackCount = stacks[inserted.first->second].count;
+            if (count > std::numeric_limits<uint32_t>::max() - stackCount) {
+                throw std::overflow_error("Слишком много предметов в стопке");
+            }
+            stackCount += count;
+        }
+        total += count;
+    }
+
+    // Removes up to count items and returns how many were removed
+    uint32_t remove(uint32_t item, uint32_t count = 1) {
+        auto found = slotOf.find(item);
+        if (found == slotOf.end()) {
+            return 0;
+        }
+        ItemStack& stack = stacks[found->second];
+        const uint32_t removed = std::min(count, stack.count);
+        stack.count -= removed;
+        total -= removed;
+        if (stack.count == 0) {
+            slotOf.erase(found);
+            if (++emptyStacks > stacks.size() / 2) {
+                compact();
+            }
+        }
+        return removed;
+    }
+
+    uint32_t count(uint32_t item) const {
+        auto found = slotOf.find(item);
+        return found == slotOf.end() ? 0 : stacks[found->second].count;
+    }
+
+    // Adds all of the loot or, if a stack would overflow, none of it
+    void addLoot(const LootTable& loot) {
+        slotOf.reserve(slotOf.size() + loot.size());
+        stacks.reserve(stacks.size() + loot.size());
+        size_t added = 0;
+        try {
+            for (; added < loot.size(); ++added) {
+                add(loot[added].item, loot[added].count);
+            }
+        } catch (const std::overflow_error&) {
+            while (added > 0) {
+                --added;
+                remove(loot[added].item, loot[added].count);
+            }
+            throw;
+        }
+    }
+
+    // Calls f(const ItemStack&) for every stack in order of acquisition
+    template <typename F>
+    void forEach(F f) const {
+        for (const ItemStack& stack : stacks) {
+            if (stack.count > 0) {
+                f(stack);
+            }
+        }
+    }
+
+    size_t distinctItems() const {
+        return slotOf.size();
+    }
+
+    unsigned long long totalItems() const {
+        return total;
+    }
+
+    void addItem(const std::string& item) {
+        add(ItemRegistry::global().intern(item));
+        std::cout << item << " добавлен в инвентарь." << std::endl;
+    }
+
+    bool removeItem(const std::string& item) {
+        uint32_t id;
+        if (ItemRegistry::global().find(item, id) && remove(id) > 0) {
+            std::cout << item << " удален из инвентаря." << std::endl;
+            return true;
+        }
+        std::cout << item << " не найден в инвентаре." << std::endl;
+        return false;
+    }
+
+    void displayInventory() const {
+        std::cout << "Инвентарь:" << std::endl;
+        forEach([](const ItemStack& stack) {
+            std::cout << "- " << ItemRegistry::global().name(stack.item);
+            if (stack.count > 1) {
+                std::cout << " x" << stack.count;
+            }
+            std::cout << std::endl;
+        });
+    }
+};
+
+
+// Binary save: a 16-byte header (magic "L9SV", version, payload size and
+// FNV-1a checksum of the payload), then the character and the inventory
+// stacks with item names. The game has no random state yet; a later
+// version of the format can add it.
+const char SAVE_MAGIC[4] = {'L', '9', 'S', 'V'};
+const uint32_t SAVE_VERSION = 1;
+const size_t SAVE_HEADER_SIZE = 16;
+
+inline uint32_t saveChecksum(const char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+    }
+    return hash;
+}
+
+inline void putSaveInt(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void putSaveString(std::string& out, const std::string& value) {
+    if (value.size() > UINT16_MAX) {
+        throw std::length_error("Слишком длинная строка в сохранении");
+    }
+    uint16_t length = static_cast<uint16_t>(value.size());
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out += value;
+}
+
+// Bounds-checked reading of a save payload; any read past the end fails
+class SaveReader {
+private:
+    const char* pos;
+    const char* end;
+
+public:
+    SaveReader(const char* data, size_t size) : pos(data), end(data + size) {}
+
+    bool readInt(uint32_t& value) {
+        if (end - pos < static_cast<std::ptrdiff_t>(sizeof(value))) {
+            return false;
+        }
+        std::memcpy(&value, pos, sizeof(value));
+        pos += sizeof(value);
+        return true;
+    }
+
+    bool readInt(int& value) {
+        uint32_t raw;
+        if (!readInt(raw)) {
+            return false;
+        }
+        value = static_cast<int32_t>(raw);
+        return true;
+    }
+
+    bool readString(std::string& value) {
+        uint16_t length;
+        if (end - pos < static_cast<std::ptrdiff_t>(sizeof(length))) {
+            return false;
+        }
+        std::memcpy(&length, pos, sizeof(length));
+        pos += sizeof(length);
+        if (end - pos < length) {
+            return false;
+        }
+        value.assign(pos, length);
+        pos += length;
+        return true;
+    }
+
+    bool atEnd() const {
+        return pos == end;
+    }
+};
+
+// Item ids in the inventory are resolved through registry
+inline std::string encodeSave(const Character& player, const Inventory& inventory,
+                              const ItemRegistry& registry = ItemRegistry::global()) {
+    std::string data(SAVE_HEADER_SIZE, '\0');
+    putSaveString(data, player.getName());
+    putSaveInt(data, static_cast<uint32_t>(player.getHealth()));
+    putSaveInt(data, static_cast<uint32_t>(player.getAttack()));
+    putSaveInt(data, static_cast<uint32_t>(player.getDefense()));
+    putSaveInt(data, static_cast<uint32_t>(player.getLevel()));
+    putSaveInt(data, static_cast<uint32_t>(player.getExperience()));
+    putSaveInt(data, static_cast<uint32_t>(inventory.distinctItems()));
+    inventory.forEach([&data, &registry](const ItemStack& stack) {
+        putSaveString(data, registry.name(stack.item));
+        putSaveInt(data, stack.count);
+    });
+
+    const uint32_t payloadSize = static_cast<uint32_t>(data.size() - SAVE_HEADER_SIZE);
+    const uint32_t checksum = saveChecksum(data.data() + SAVE_HEADER_SIZE, payloadSize);
+    std::memcpy(&data[0], SAVE_MAGIC, sizeof(SAVE_MAGIC));
+    std::memcpy(&data[4], &SAVE_VERSION, sizeof(SAVE_VERSION));
+    std::memcpy(&data[8], &payloadSize, sizeof(payloadSize));
+    std::memcpy(&data[12], &checksum, sizeof(checksum));
+    return data;
+}
+
+inline bool isBinarySave(const std::string& data) {
+    return data.size() >= SAVE_HEADER_SIZE && std::memcmp(data.data(), SAVE_MAGIC, sizeof(SAVE_MAGIC)) == 0;
+}
+
+// Fills player and inventory only if the whole save is valid; item names are
+// interned into registry only after that, so a rejected save leaves it as is
+inline bool decodeSave(const std::string& data, Character& player, Inventory& inventory,
+                       ItemRegistry& registry = ItemRegistry::global()) {
+    if (!isBinarySave(data)) {
+        return false;
+    }
+    uint32_t version, payloadSize, checksum;
+    std::memcpy(&version, data.data() + 4, sizeof(version));
+    std::memcpy(&payloadSize, data.data() + 8, sizeof(payloadSize));
+    std::memcpy(&checksum, data.data() + 12, sizeof(checksum));
+    if (version != SAVE_VERSION || payloadSize != data.size() - SAVE_HEADER_SIZE ||
+        checksum != saveChecksum(data.data() + SAVE_HEADER_SIZE, payloadSize)) {
+        return false;
+    }
+
+    SaveReader reader(data.data() + SAVE_HEADER_SIZE, payloadSize);
+    std::string name;
+    int health, attack, defense, level, experience;
+    uint32_t stacks;
+    if (!reader.readString(name) || !reader.readInt(health) || !reader.readInt(attack) ||
+        !reader.readInt(defense) || !reader.readInt(level) || !reader.readInt(experience) ||
+        !reader.readInt(stacks) || health < 0) {
+        return false;
+    }
+    // encodeSave writes one stack per item, so a repeated name is corrupt
+    std::vector<std::pair<std::string, uint32_t>> items;
+    std::unordered_set<std::string> seen;
+    for (uint32_t i = 0; i < stacks; ++i) {
+        std::string item;
+        uint32_t count;
+        if (!reader.readString(item) || !reader.readInt(count) || !seen.insert(item).second) {
+            return false;
+        }
+        items.emplace_back(std::move(item), count);
+    }
+    if (!reader.atEnd()) {
+        return false;
+    }
+    Inventory loaded;
+    for (const auto& entry : items) {
+        loaded.add(registry.intern(entry.first), entry.second);
+    }
+    player = Character(name, health, attack, defense, level, experience);
+    inventory = std::move(loaded);
+    return true;
+}
+
+// Flushes a file (or, with O_DIRECTORY, a directory) to disk
+inline bool syncPath(const std::string& path, int flags) {
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = open(path.c_str(), O_RDONLY | flags);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+#else
+    (void)path;
+    (void)flags;
+    return true;
+#endif
+}
+
+// Writes a temporary file and renames it over the target, so after a crash
+// of the program the target is either the old or the new save. Only with
+// sync does that also hold after a power loss: the data is flushed before
+// the rename and the directory entry after it. On failure the temporary
+// file is removed and the target is left untouched.
+inline bool writeFileAtomically(const std::string& filename, const std::string& data, bool sync) {
+    const std::string tempFilename = filename + ".tmp";
+    std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    file.close();
+    std::error_code error;
+    if (file.fail() || (sync && !syncPath(tempFilename, 0))) {
+        std::filesystem::remove(tempFilename, error);
+        return false;
+    }
+    std::filesystem::rename(tempFilename, filename, error);
+    if (error) {
+        std::filesystem::remove(tempFilename, error);
+        return false;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    if (sync) {
+        std::string directory = std::filesystem::path(filename).parent_path().string();
+        return syncPath(directory.empty() ? "." : directory, O_DIRECTORY);
+    }
+#endif
+    return true;
+}
+
+inline bool readWholeFile(const std::string& filename, std::string& data) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    return static_cast<bool>(file.read(&data[0], static_cast<std::streamsize>(data.size())));
+}
+
+
+class Game {
+private:
+    Character player;
+    Inventory inventory;
+    Logger<std::string> logger;
+
+public:
+    Game(const std::string& playerName)
+        : player(playerName, 100, 20, 10), logger("game_log.txt", loggerOptions()) {}
+
+    // The combat loop only enqueues log lines; a writer thread writes them.
+    // Categories can be routed to their own files through categoryFiles.
+    static LoggerOptions loggerOptions() {
+        LoggerOptions options;
+        options.async = true;
+        return options;
+    }
+
+    void start() {
+        std::cout << "Добро пожаловать в RPG игру, " << player.getName() << "!" << std::endl;
+        player.displayInfo();
+        inventory.displayInventory();
+    }
+
+    // Hits that take health below zero kill on either side (see applyHit).
+    // Before the combat core, such an overshooting hit threw from setHealth:
+    // a finishing blow ended the fight without experience, and a monster hit
+    // ended it with the player's health unchanged. Now the player gets the
+    // experience, and a monster hit that overshoots defeats the player.
+    void battle(Monster& monster) {
+        std::cout << "Дикий " << monster.getName() << " появился!" << std::endl;
+        monster.displayInfo();
+
+        while (player.getHealth() > 0 && monster.getHealth() > 0) {
+            int damage = hitDamage(player.getAttack(), monster.getDefense());
+            if (damage > 0) {
+                HitResult hit = monster.receiveHit(damage);
+                logger.logEvent<LogEvent::Attack>(player.getName(), monster.getName(), damage);
+                std::cout << player.getName() << " атакует " << monster.getName() << " и наносит " << damage << " урона!" << std::endl;
+                if (hit.defeated) {
+                    logger.logEvent<LogEvent::Defeated>(monster.getName());
+                }
+            } else {
+                logger.logEvent<LogEvent::AttackIneffective>(player.getName(), monster.getName());
+                std::cout << player.getName() << " атакует " << monster.getName() << ", но это неэффективно!" << std::endl;
+            }
+
+            if (monster.getHealth() <= 0) {
+                std::cout << monster.getName() << " побежден!" << std::endl;
+                player.gainExperience(50, logger);
+                break;
+            }
+
+            if (monster.strike(player, logger).defeated) {
+                std::cout << player.getName() << " был побежден! Игра окончена." << std::endl;
+                break;
+            }
+        }
+    }
+
+    // sync: wait until the save is on disk, so it survives a power loss;
+    // without it the save only survives a crash of the game itself
+    void saveGame(const std::string& filename, bool sync = true) {
+        if (!writeFileAtomically(filename, encodeSave(player, inventory), sync)) {
+            std::cout << "Не удалось открыть файл сохранения." << std::endl;
+            return;
+        }
+        logger.logEvent<LogEvent::GameSaved>(filename);
+        std::cout << "Игра сохранена в " << filename << std::endl;
+    }
+
+    // Reads binary saves and the older text saves without an inventory
+    void loadGame(const std::string& filename) {
+        std::string data;
+        if (!readWholeFile(filename, data)) {
+            std::cout << "Не удалось открыть файл сохранения." << std::endl;
+            return;
+        }
+        if (isBinarySave(data)) {
+            if (!decodeSave(data, player, inventory)) {
+                std::cout << "Файл сохранения поврежден." << std::endl;
+                return;
+            }
+        } else {
+            std::istringstream loadFile(data);
+            std::string name;
+            int health, attack, defense, level, experience;
+            if (!(loadFile >> name >> health >> attack >> defense >> level >> experience) || health < 0) {
+                std::cout << "Файл сохранения поврежден." << std::endl;
+                return;
+            }
+            player = Character(name, health, attack, defense, level, experience);
+        }
+        std::cout << "Загружен уровень игрока: " << player.getLevel() << ", опыт: " << player.getExperience() << std::endl;
+        logger.logEvent<LogEvent::GameLoaded>(filename);
+        std::cout << "Игра загружена из " << filename << std::endl;
+    }
+
+    void showInventory() const {
+        inventory.displayInventory();
+    }
+
+    void addItemToInventory(const std::string& item) {
+        inventory.addItem(item);
+        logger.logEvent<LogEvent::ItemAdded>(item);
+    }
+
+    void removeItemFromInventory(const std::string& item) {
+        if (inventory.removeItem(item)) {
+            logger.logEvent<LogEvent::ItemRemoved>(item);
+        }
+    }
+
+    void addLootToInventory(const LootTable& loot) {
+        inventory.addLoot(loot);
+        std::cout << "Добыча добавлена в инвентарь, предметов: " << inventory.totalItems() << std::endl;
+    }
+
+    std::string getPlayerName() const {
+        return player.getName();
+    }
+
+    int getPlayerHealth() const {
+        return player.getHealth();
+    }
+};
+
+// Headless battle simulation for balance tuning: the rules of Game::battle
+// (the hero strikes first, damage is attack minus defense) without console or
+// log output, over many battles with random hero stats on all cores.
+struct StatRange {
+    int min;
+    int max;
+};
+
+struct SimulationConfig {
+    int monsterHealth = 0;
+    int monsterAttack = 0;
+    int monsterDefense = 0;
+    StatRange health{50, 100};
+    StatRange attack{10, 30};
+    StatRange defense{5, 20};
+    long long battles = 1000000;
+    unsigned threads = 0;   // 0: one per core
+    int maxTurns = 1000;    // a battle where nobody can hurt the other is a draw
+    uint64_t seed = 42;
+
+    void setMonster(const Monster& monster) {
+        monsterHealth = monster.getHealth();
+        monsterAttack = monster.getAttack();
+        monsterDefense = monster.getDefense();
+    }
+};
+
+struct SimulationResult {
+    static const int TURN_BUCKETS = 64;      // the last bucket holds 63+ turns
+    static const int DAMAGE_BUCKETS = 11;    // by 10 HP, the last bucket holds 100+
+
+    long long wins = 0;
+    long long losses = 0;
+    long long draws = 0;
+    long long rounds = 0;
+    long long turnsToKill[TURN_BUCKETS] = {};
+    long long damageTaken[DAMAGE_BUCKETS] = {};
+
+    long long battles() const {
+        return wins + losses + draws;
+    }
+
+    void merge(const SimulationResult& other) {
+        wins += other.wins;
+        losses += other.losses;
+        draws += other.draws;
+        rounds += other.rounds;
+        for (int i = 0; i < TURN_BUCKETS; ++i) {
+            turnsToKill[i] += other.turnsToKill[i];
+        }
+        for (int i = 0; i < DAMAGE_BUCKETS; ++i) {
+            damageTaken[i] += other.damageTaken[i];
+        }
+    }
+};
+
+// splitmix64: a few instructions per number, one generator per thread
+class SimulationRandom {
+private:
+    uint64_t state;
+
+public:
+    explicit SimulationRandom(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    int uniform(const StatRange& range) {
+        return range.min + static_cast<int>(next() % static_cast<uint64_t>(range.max - range.min + 1));
+    }
+};
+
+// Counts into a local result so that threads do not share cache lines
+inline void simulateBattles(const SimulationConfig& config, long long battles, uint64_t seed,
+                            SimulationResult& output) {
+    SimulationRandom random(seed);
+    SimulationResult result;
+    for (long long b = 0; b < battles; ++b) {
+        int health = random.uniform(config.health);
+        const int playerDamage = hitDamage(random.uniform(config.attack), config.monsterDefense);
+        const int monsterDamage = hitDamage(config.monsterAttack, random.uniform(config.defense));
+        int monsterHealth = config.monsterHealth;
+        int taken = 0;
+        int turns = 0;
+        for (;;) {
+            if (turns == config.maxTurns) {
+                ++result.draws;
+                break;
+            }
+            ++turns;
+            if (applyHit(monsterHealth, playerDamage).defeated) {
+                ++result.wins;
+                ++result.turnsToKill[std::min(turns, SimulationResult::TURN_BUCKETS - 1)];
+                break;
+            }
+            HitResult hit = applyHit(health, monsterDamage);
+            taken += hit.damage;
+            if (hit.defeated) {
+                ++result.losses;
+                break;
+            }
+        }
+        result.rounds += turns;
+        ++result.damageTaken[std::min(taken / 10, SimulationResult::DAMAGE_BUCKETS - 1)];
+    }
+    output = result;
+}
+
+// Splits the battles between threads; every thread fills its own result
+inline SimulationResult runSimulation(const SimulationConfig& config) {
+    unsigned threads = config.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<SimulationResult> results(threads);
+    std::vector<std::thread> workers;
+    SimulationRandom seeds(config.seed);
+    for (unsigned t = 0; t < threads; ++t) {
+        long long battles = config.battles / threads + (t < config.battles % threads ? 1 : 0);
+        workers.emplace_back(simulateBattles, std::cref(config), battles, seeds.next(), std::ref(results[t]));
+    }
+    SimulationResult total;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers[t].join();
+        total.merge(results[t]);
+    }
+    return total;
+}
+
+inline void printSimulationResult(const SimulationResult& result, double seconds) {
+    const double battles = static_cast<double>(std::max(result.battles(), 1LL));
+    std::cout << "Боев: " << result.battles() << ", побед: " << 100.0 * result.wins / battles
+              << "%, поражений: " << 100.0 * result.losses / battles
+              << "%, ничьих: " << 100.0 * result.draws / battles << "%" << std::endl;
+    std::cout << "Раундов: " << result.rounds << ", " << static_cast<long long>(result.rounds / seconds)
+              << " раундов/с, " << static_cast<long long>(result.battles() / seconds) << " боев/с" << std::endl;
+    std::cout << "Ходов до победы:" << std::endl;
+    for (int i = 1; i < SimulationResult::TURN_BUCKETS; ++i) {
+        if (result.turnsToKill[i] > 0) {
+            std::cout << "  " << i << (i == SimulationResult::TURN_BUCKETS - 1 ? "+" : "") << ": "
+                      << 100.0 * result.turnsToKill[i] / std::max(result.wins, 1LL) << "%" << std::endl;
+        }
+    }
+    std::cout << "Полученный урон за бой:" << std::endl;
+    for (int i = 0; i < SimulationResult::DAMAGE_BUCKETS; ++i) {
+        if (result.damageTaken[i] > 0) {
+            std::cout << "  " << i * 10;
+            if (i == SimulationResult::DAMAGE_BUCKETS - 1) {
+                std::cout << "+";
+            } else {
+                std::cout << "-" << i * 10 + 9;
+            }
+            std::cout << ": " << 100.0 * result.damageTaken[i] / battles << "%" << std::endl;
+        }
+    }
+}
+
+// Buffers everything written to a stream in batch mode: std::endl does not
+// flush it, so output is written in large blocks instead of line by line.
+// The stream is redirected for the lifetime of the object.
+class BatchOutput : public std::streambuf {
+private:
+    std::ostream& stream;
+    std::streambuf* target;
+    std::vector<char> buffer;
+
+    void flushBuffer() {
+        target->sputn(pbase(), pptr() - pbase());
+        target->pubsync();
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        flushBuffer();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override {
+        return 0;
+    }
+
+public:
+    explicit BatchOutput(std::ostream& stream, size_t size = 1 << 16)
+        : stream(stream), target(stream.rdbuf()), buffer(size) {
+        setp(buffer.data(), buffer.data() + buffer.size());
+        stream.rdbuf(this);
+    }
+
+    ~BatchOutput() {
+        stream.rdbuf(target);
+        flushBuffer();
+    }
+
+    BatchOutput(const BatchOutput&) = delete;
+    BatchOutput& operator=(const BatchOutput&) = delete;
+};
+
+// Number and total time of the executed commands of one type
+struct BatchCommandStats {
+    uint64_t count = 0;
+    double seconds = 0;
+};
+
+// Prints total wall time and throughput per command type to std::cerr,
+// so that stdout carries only the results of the commands
+void reportBatchStats(const std::map<std::string, BatchCommandStats>& stats, double seconds, size_t errors) {
+    uint64_t total = 0;
+    for (const auto& entry : stats) {
+        total += entry.second.count;
+    }
+    std::cerr << "Команд: " << total << ", ошибок: " << errors << ", время: " << seconds * 1000 << " мс, "
+              << static_cast<long long>(total / std::max(seconds, 1e-9)) << " команд/с" << std::endl;
+    for (const auto& entry : stats) {
+        std::cerr << "  " << entry.first << ": " << entry.second.count << ", "
+                  << static_cast<long long>(entry.second.count / std::max(entry.second.seconds, 1e-9))
+                  << " команд/с" << std::endl;
+    }
+}
+
+// Benchmark: messages per second of the synchronous logger (one flush per
+// line) against the asynchronous one with one and several producer threads
+void benchmarkLogger() {
+    const int messages = 200000;
+    const std::string filename = "logger_bench.txt";
+    const std::string message = "Герой атакует Орк и наносит 10 урона!";
+    auto seconds = [](std::chrono::steady_clock::time_point from) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+    };
+
+    std::remove(filename.c_str());
+    {
+        Logger<std::string> logger(filename);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < messages; ++i) {
+            logger.log(message);
+        }
+        std::cout << "Синхронный: " << static_cast<long long>(messages / seconds(start)) << " сообщений/с" << std::endl;
+    }
+
+    for (int producers : {1, 4}) {
+        std::remove(filename.c_str());
+        LoggerOptions options;
+        options.async = true;
+        double enqueueSeconds = 0;
+        auto start = std::chrono::steady_clock::now();
+        {
+            Logger<std::string> logger(filename, options);
+            std::vector<std::thread> threads;
+            for (int p = 0; p < producers; ++p) {
+                threads.emplace_back([&logger, &message, messages, producers]() {
+                    for (int i = 0; i < messages / producers; ++i) {
+                        logger.log(message);
+                    }
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            enqueueSeconds = seconds(start);
+        }
+        std::cout << "Асинхронный, потоков " << producers << ": "
+                  << static_cast<long long>(messages / enqueueSeconds) << " сообщений/с в вызывающих потоках, "
+                  << static_cast<long long>(messages / seconds(start)) << " сообщений/с до записи на диск"
+                  << std::endl;
+    }
+
+    std::remove(filename.c_str());
+    {
+        LoggerOptions options;
+        options.async = true;
+        options.queueCapacity = 256;
+        options.overflowPolicy = LogOverflowPolicy::Drop;
+        Logger<std::string> logger(filename, options);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < messages; ++i) {
+            logger.log(message);
+        }
+        std::cout << "Асинхронный с отбрасыванием (очередь 256): "
+                  << static_cast<long long>(messages / seconds(start)) << " сообщений/с, отброшено "
+                  << logger.dropped() << std::endl;
+    }
+    std::remove(filename.c_str());
+}
+
+// Benchmark: cost per call in the calling thread of a message built by
+// string concatenation against a structured record, and the total time
+// until everything is on disk as text or as binary records
+void benchmarkLogRecords() {
+    const int messages = 200000;
+    const std::string filename = "logger_bench.txt";
+    const std::string attacker = "Герой";
+    const std::string target = "Орк";
+    auto seconds = [](std::chrono::steady_clock::time_point from) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+    };
+    auto report = [messages](const char* title, double callSeconds, double totalSeconds) {
+        std::cout << title << ": " << callSeconds * 1e9 / messages << " нс/вызов, "
+                  << static_cast<long long>(messages / totalSeconds) << " сообщений/с до записи на диск" << std::endl;
+    };
+
+    for (int mode = 0; mode < 3; ++mode) {
+        std::remove(filename.c_str());
+        LoggerOptions options;
+        options.async = true;
+        options.queueCapacity = 1 << 16;
+        options.binary = mode == 2;
+        double callSeconds = 0;
+        auto start = std::chrono::steady_clock::now();
+        {
+            Logger<std::string> logger(filename, options);
+            for (int i = 0; i < messages; ++i) {
+                if (mode == 0) {
+                    logger.log(attacker + " атакует " + target + " и наносит " + std::to_string(i % 100) + " урона!");
+                } else {
+                    logger.logEvent<LogEvent::Attack>(attacker, target, i % 100);
+                }
+            }
+            callSeconds = seconds(start);
+        }
+        const char* titles[] = {"Строки", "Записи, текст в потоке записи", "Записи, двоичный журнал"};
+        report(titles[mode], callSeconds, seconds(start));
+    }
+    if (!logEventEnabled(LogEvent::Attack)) {
+        std::cout << "События атаки исключены при компиляции (LOG_MIN_LEVEL / LOG_CATEGORIES)" << std::endl;
+    }
+    std::remove(filename.c_str());
+}
+
+// Benchmark: battle rounds per second of the headless simulator against
+// every monster with random hero stats
+void benchmarkSimulation() {
+    Chubaka chubaka;
+    Dynozavr dynozavr;
+    Ork ork;
+    const Monster* monsters[] = {&chubaka, &dynozavr, &ork};
+    for (const Monster* monster : monsters) {
+        SimulationConfig config;
+        config.setMonster(*monster);
+        auto start = std::chrono::steady_clock::now();
+        SimulationResult result = runSimulation(config);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << monster->getName() << ": " << 100.0 * result.wins / result.battles() << "% побед, "
+                  << static_cast<long long>(result.rounds / seconds) << " раундов/с" << std::endl;
+    }
+}
+
+// Benchmark: cost of one kill when death is reported by an exception
+// (setHealth below zero, as Game::battle used to do) and by a HitResult
+void benchmarkCombatCore() {
+    const int kills = 200000;
+    Ork ork;
+    const int damage = ork.getHealth() + 1;
+    auto seconds = [](std::chrono::steady_clock::time_point from) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+    };
+
+    int counted = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kills; ++i) {
+        ork.trySetHealth(50);
+        try {
+            ork.setHealth(ork.getHealth() - damage);
+        } catch (const std::invalid_argument&) {
+            ++counted;
+        }
+    }
+    std::cout << "Исключения: " << seconds(start) * 1e9 / kills << " нс/убийство (" << counted << ")" << std::endl;
+
+    counted = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kills; ++i) {
+        ork.trySetHealth(50);
+        if (ork.receiveHit(damage).defeated) {
+            ++counted;
+        }
+    }
+    std::cout << "HitResult: " << seconds(start) * 1e9 / kills << " нс/убийство (" << counted << ")" << std::endl;
+}
+
+// Benchmark: memory and hero-vs-horde rounds of polymorphic Monster objects
+// against MonsterInstance records that share templates from a catalog
+void benchmarkMonsterCatalog() {
+    const int kinds = 1000;
+    const size_t count = 1000000;
+    const int heroAttack = 40;
+    const int heroDefense = 20;
+    auto seconds = [](std::chrono::steady_clock::time_point from) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+    };
+
+    MonsterCatalog catalog;
+    for (int i = 0; i < kinds; ++i) {
+        catalog.add("Монстр номер " + std::to_string(i), 40 + i % 200, 10 + i % 30, i % 35);
+    }
+    std::vector<std::unique_ptr<Monster>> objects;
+    std::vector<MonsterInstance> horde;
+    objects.reserve(count);
+    horde.reserve(count);
+    size_t objectBytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t id = static_cast<uint32_t>(i % catalog.size());
+        objects.emplace_back(new Monster(catalog[id]));
+        const std::string& name = objects.back()->getName();
+        objectBytes += sizeof(objects.back()) + sizeof(Monster) +
+                       (name.capacity() > std::string().capacity() ? name.capacity() + 1 : 0);
+        horde.push_back(catalog.spawn(id));
+    }
+    std::cout << "Объекты Monster: " << objectBytes / count << " байт на монстра, записи: "
+              << sizeof(MonsterInstance) << " байт на монстра" << std::endl;
+
+    long long hits = 0;
+    long long damage = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t alive = count; alive > 0;) {
+        for (auto& monster : objects) {
+            if (monster->getHealth() <= 0) {
+                continue;
+            }
+            ++hits;
+            if (monster->receiveHit(hitDamage(heroAttack, monster->getDefense())).defeated) {
+                --alive;
+            } else {
+                damage += hitDamage(monster->getAttack(), heroDefense);
+            }
+        }
+    }
+    std::cout << "Объекты Monster: " << static_cast<long long>(hits / seconds(start)) << " ударов/с" << std::endl;
+
+    long long flatDamage = 0;
+    start = std::chrono::steady_clock::now();
+    hits = 0;
+    for (size_t alive = count; alive > 0;) {
+        HordeRoundResult round = resolveHordeRound(catalog, horde, heroAttack, heroDefense);
+        hits += round.attacked;
+        alive -= round.killed;
+        flatDamage += round.damageTaken;
+    }
+    std::cout << "Записи каталога: " << static_cast<long long>(hits / seconds(start)) << " ударов/с"
+              << (flatDamage == damage ? "" : " (результаты различаются!)") << std::endl;
+}
+
+// Benchmark: loot drops, counts and removals on inventories of 10k-1M
+// items: the former vector of strings against stacks with a hash index
+void benchmarkInventory() {
+    auto seconds = [](std::chrono::steady_clock::time_point from) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+    };
+    ItemRegistry registry;   // keeps benchmark names out of the game's registry
+    for (size_t items : {size_t(10000), size_t(100000), size_t(1000000)}) {
+        const size_t kinds = items / 4;
+        const size_t removals = 1000;
+        std::vector<std::string> names(kinds);
+        for (size_t k = 0; k < kinds; ++k) {
+            names[k] = "Предмет " + std::to_string(k);
+        }
+
+        std::vector<std::string> vectorInventory;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < items; ++i) {
+            vectorInventory.push_back(names[(i * 7919) % kinds]);
+        }
+        double addSeconds = seconds(start);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < removals; ++i) {
+            auto it = std::find(vectorInventory.begin(), vectorInventory.end(), names[(i * 104729) % kinds]);
+            if (it != vectorInventory.end()) {
+                vectorInventory.erase(it);
+            }
+        }
+        double removeSeconds = seconds(start);
+        std::cout << items << " предметов, вектор строк: добавление " << addSeconds * 1e9 / items
+                  << " нс, удаление " << removeSeconds * 1e9 / removals << " нс" << std::endl;
+
+        Inventory inventory;
+        LootTable loot;
+        loot.reserve(items);
+        for (size_t i = 0; i < items; ++i) {
+            loot.push_back({registry.intern(names[(i * 7919) % kinds]), 1});
+        }
+        start = std::chrono::steady_clock::now();
+        inventory.addLoot(loot);
+        addSeconds = seconds(start);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < removals; ++i) {
+            inventory.remove(loot[(i * 104729) % items].item);
+        }
+        removeSeconds = seconds(start);
+        start = std::chrono::steady_clock::now();
+        unsigned long long counted = 0;
+        for (size_t i = 0; i < items; ++i) {
+            counted += inventory.count(loot[i].item);
+        }
+        double countSeconds = seconds(start);
+        std::cout << items << " предметов, стопки: добавление " << addSeconds * 1e9 / items
+                  << " нс, удаление " << removeSeconds * 1e9 / removals << " нс, подсчет "
+                  << countSeconds * 1e9 / items << " нс (" << inventory.distinctItems() << " стопок, "
+                  << (counted > 0 ? "ок" : "пусто") << ")" << std::endl;
+    }
+}
+
+// Benchmark: time of a binary save (encoding and atomic replacement of the
+// file, with and without fsync) and of a load of a typical game
+void benchmarkSaveGame() {
+    const int rounds = 1000;
+    const std::string filename = "save_bench.bin";
+    auto seconds = [](std::chrono::steady_clock::time_point from) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+    };
+    Character player("Герой", 80, 20, 10, 5, 40);
+    ItemRegistry registry;
+    Inventory inventory;
+    for (int i = 0; i < 50; ++i) {
+        inventory.add(registry.intern("Предмет " + std::to_string(i)), 1 + i % 5);
+    }
+
+    for (bool sync : {false, true}) {
+        const int count = sync ? rounds / 10 : rounds;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i) {
+            writeFileAtomically(filename, encodeSave(player, inventory, registry), sync);
+        }
+        std::cout << "Сохранение" << (sync ? " с fsync" : "") << ": " << seconds(start) * 1e6 / count << " мкс" << std::endl;
+    }
+
+    Character loadedPlayer("", 0, 0, 0);
+    Inventory loadedInventory;
+    std::string data;
+    int loaded = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        loaded += readWholeFile(filename, data) && decodeSave(data, loadedPlayer, loadedInventory, registry);
+    }
+    std::cout << "Загрузка: " << seconds(start) * 1e6 / rounds << " мкс (" << data.size() << " байт, "
+              << loaded << " успешно)" << std::endl;
+    std::remove(filename.c_str());
+}
+
+// laba9 --simulate chubaka|dynozavr|ork [BATTLES] [THREADS]: simulates
+// battles with random hero stats and prints win rate and distributions
+int runSimulate(int argc, char* argv[]) {
+    std::unique_ptr<Monster> monster;
+    std::string kind = argc > 2 ? argv[2] : "";
+    if (kind == "chubaka") {
+        monster.reset(new Chubaka());
+    } else if (kind == "dynozavr") {
+        monster.reset(new Dynozavr());
+    } else if (kind == "ork") {
+        monster.reset(new Ork());
+    } else {
+        std::cerr << "Использование: " << argv[0] << " --simulate chubaka|dynozavr|ork [БОИ] [ПОТОКИ]" << std::endl;
+        return 2;
+    }
+    SimulationConfig config;
+    config.setMonster(*monster);
+    // Whole numbers only; a value outside [min, max] is rejected
+    auto parse = [](const char* text, long long min, long long max, long long& value) {
+        const char* end = text + std::strlen(text);
+        auto result = std::from_chars(text, end, value);
+        return result.ec == std::errc() && result.ptr == end && value >= min && value <= max;
+    };
+    const long long maxThreads = 4LL * std::max(1u, std::thread::hardware_concurrency());
+    long long value;
+    if (argc > 3) {
+        if (!parse(argv[3], 1, std::numeric_limits<long long>::max(), value)) {
+            std::cerr << "Число боёв должно быть целым положительным числом" << std::endl;
+            return 2;
+        }
+        config.battles = value;
+    }
+    if (argc > 4) {
+        if (!parse(argv[4], 1, maxThreads, value)) {
+            std::cerr << "Число потоков должно быть от 1 до " << maxThreads << std::endl;
+            return 2;
+        }
+        config.threads = static_cast<unsigned>(value);
+    }
+    auto start = std::chrono::steady_clock::now();
+    SimulationResult result = runSimulation(config);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printSimulationResult(result, seconds);
+    return 0;
+}
+
+// laba9 --decode-log FILE: prints a binary journal (LoggerOptions::binary)
+// as text, one record per line
+int runDecodeLog(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Использование: " << argv[0] << " --decode-log ФАЙЛ" << std::endl;
+        return 2;
+    }
+    std::ifstream file(argv[2], std::ios::binary);
+    if (!file) {
+        std::cerr << "Не удалось открыть файл: " << argv[2] << std::endl;
+        return 2;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string line;
+    size_t pos = 0;
+    {
+        BatchOutput output(std::cout);
+        while (pos + LOG_RECORD_HEADER_SIZE <= data.size()) {
+            uint16_t payload;
+            std::memcpy(&payload, data.data() + pos + 2, sizeof(payload));
+            const size_t size = LOG_RECORD_HEADER_SIZE + payload;
+            line.clear();
+            if (pos + size > data.size() || !formatLogRecord(data.data() + pos, size, line)) {
+                break;
+            }
+            line += '\n';
+            std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+            pos += size;
+        }
+    }
+    if (pos != data.size()) {
+        std::cerr << "Повреждённая запись по смещению " << pos << std::endl;
+        return 2;
+    }
+    return 0;
+}
+
+// laba9 --batch [FILE]: executes commands from FILE (or stdin) without the
+// menu, one per line; empty lines and lines starting with # are skipped.
+//   battle chubaka|dynozavr|ork|NAME (a kind from the monster catalog)
+//   load_monsters FILE (see MonsterCatalog::loadFromFile)
+//   add_item ITEM | remove_item ITEM | inventory
+//   add_loot ITEM:COUNT,ITEM:COUNT,...
+//   status
+//   save FILE | load FILE
+// Total wall time and throughput per command type go to std::cerr.
+int runBatch(int argc, char* argv[]) {
+    std::ifstream file;
+    std::istream* input = &std::cin;
+    if (argc > 2 && std::string(argv[2]) != "-") {
+        file.open(argv[2]);
+        if (!file) {
+            std::cerr << "Не удалось открыть файл команд " << argv[2] << std::endl;
+            return 1;
+        }
+        input = &file;
+    }
+
+    std::map<std::string, BatchCommandStats> stats;
+    size_t errors = 0;
+    auto start = std::chrono::steady_clock::now();
+    {
+        BatchOutput output(std::cout);
+        Game game("Герой");
+        MonsterCatalog catalog;
+        std::string line;
+        while (std::getline(*input, line)) {
+            size_t begin = line.find_first_not_of(" \t");
+            if (begin == std::string::npos || line[begin] == '#') {
+                continue;
+            }
+            size_t end = line.find_last_not_of(" \t\r");
+            size_t split = line.find_first_of(" \t", begin);
+            std::string command = line.substr(begin, std::min(split, end + 1) - begin);
+            std::string argument;
+            if (split != std::string::npos && split < end) {
+                size_t argumentBegin = line.find_first_not_of(" \t", split);
+                argument = line.substr(argumentBegin, end + 1 - argumentBegin);
+            }
+
+            auto commandStart = std::chrono::steady_clock::now();
+            try {
+                if (command == "battle") {
+                    if (argument == "chubaka") {
+                        Chubaka chubaka;
+                        game.battle(chubaka);
+                    } else if (argument == "dynozavr") {
+                        Dynozavr dynozavr;
+                        game.battle(dynozavr);
+                    } else if (argument == "ork") {
+                        Ork ork;
+                        game.battle(ork);
+                    } else {
+                        uint32_t id;
+                        if (!catalog.find(argument, id)) {
+                            throw std::runtime_error("Неизвестный монстр: " + argument);
+                        }
+                        Monster monster(catalog[id]);
+                        game.battle(monster);
+                    }
+                } else if (command == "load_monsters") {
+                    catalog.loadFromFile(argument);
+                } else if (command == "add_item") {
+                    game.addItemToInventory(argument);
+                } else if (command == "add_loot") {
+                    // All entries are checked before any name is interned
+                    std::vector<std::pair<std::string, uint32_t>> entries;
+                    std::istringstream fields(argument);
+                    std::string entry;
+                    while (std::getline(fields, entry, ',')) {
+                        size_t colon = entry.rfind(':');
+                        if (colon == std::string::npos || colon == 0) {
+                            throw std::runtime_error("Неверная запись добычи: " + entry);
+                        }
+                        // from_chars rejects signs and counts above UINT32_MAX
+                        uint32_t count = 0;
+                        const char* countEnd = entry.data() + entry.size();
+                        auto parsed = std::from_chars(entry.data() + colon + 1, countEnd, count);
+                        if (parsed.ec != std::errc() || parsed.ptr != countEnd) {
+                            throw std::runtime_error("Неверное количество в записи добычи: " + entry);
+                        }
+                        entries.emplace_back(entry.substr(0, colon), count);
+                    }
+                    LootTable loot;
+                    for (const auto& parsedEntry : entries) {
+                        loot.push_back({ItemRegistry::global().intern(parsedEntry.first), parsedEntry.second});
+                    }
+                    game.addLootToInventory(loot);
+                } else if (command == "remove_item") {
+                    game.removeItemFromInventory(argument);
+                } else if (command == "inventory") {
+                    game.showInventory();
+                } else if (command == "status") {
+                    std::cout << game.getPlayerName() << ", HP: " << game.getPlayerHealth() << std::endl;
+                } else if (command == "save") {
+                    game.saveGame(argument);
+                } else if (command == "load") {
+                    game.loadGame(argument);
+                } else {
+                    throw std::runtime_error("Неизвестная команда: " + command);
+                }
+            } catch (const std::exception& e) {
+                std::cout << "Ошибка: " << e.what() << std::endl;
+                ++errors;
+            }
+            BatchCommandStats& entry = stats[command];
+            ++entry.count;
+            entry.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - commandStart).count();
+        }
+    }
+
+    reportBatchStats(stats, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), errors);
+    return errors == 0 ? 0 : 2;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        return runBatch(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--decode-log") {
+        return runDecodeLog(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--simulate") {
+        return runSimulate(argc, argv);
+    }
+    try {
+        Game game("Герой");
+        game.start();
+
+        bool running = true;
+        while (running) {
+            std::cout << "\nВыберите действие:\n";
+            std::cout << "1. Сразиться с Чубакой\n";
+            std::cout << "2. Сразиться с Динозавром\n";
+            std::cout << "3. Сразиться с Орком\n";
+            std::cout << "4. Показать инвентарь\n";
+            std::cout << "5. Добавить предмет в инвентарь\n";
+            std::cout << "6. Удалить предмет из инвентаря\n";
+            std::cout << "7. Сохранить игру\n";
+            std::cout << "8. Загрузить игру\n";
+            std::cout << "9. Выйти\n";
+            std::cout << "10. Бенчмарки\n";
+            std::cout << "Введите выбор: ";
+
+            int choice;
+            std::cin >> choice;
+
+            switch (choice) {
+                case 1: {
+                    Chubaka chubaka;
+                    game.battle(chubaka);
+                    break;
+                }
+                case 2: {
+                    Dynozavr dynozavr;
+                    game.battle(dynozavr);
+                    break;
+                }
+                case 3: {
+                    Ork ork;
+                    game.battle(ork);
+                    break;
+                }
+                case 4: {
+                    game.showInventory();
+                    break;
+                }
+                case 5: {
+                    std::cout << "Введите предмет для добавления: ";
+                    std::string item;
+                    std::cin.ignore();
+                    std::getline(std::cin, item);
+                    game.addItemToInventory(item);
+                    break;
+                }
+                case 6: {
+                    std::cout << "Введите предмет для удаления: ";
+                    std::string item;
+                    std::cin.ignore();
+                    std::getline(std::cin, item);
+                    game.removeItemFromInventory(item);
+                    break;
+                }
+                case 7: {
+                    std::cout << "Введите имя файла для сохранения игры: ";
+                    std::string filename;
+                    std::cin >> filename;
+                    game.saveGame(filename);
+                    break;
+                }
+                case 8: {
+                    std::cout << "Введите имя файла для загрузки игры: ";
+                    std::string filename;
+                    std::cin >> filename;
+                    game.loadGame(filename);
+                    break;
+                }
+                case 9: {
+                    running = false;
+                    std::cout << "Выход из игры. До свидания!" << std::endl;
+                    break;
+                }
+                case 10: {
+                    std::cout << "1. Журнал: синхронный и асинхронный\n";
+                    std::cout << "2. Журнал: строки и двоичные записи\n";
+                    std::cout << "3. Симуляция боев\n";
+                    std::cout << "4. Смерть: исключение и HitResult\n";
+                    std::cout << "5. Монстры: объекты и каталог\n";
+                    std::cout << "6. Инвентарь: вектор и стопки\n";
+                    std::cout << "7. Сохранение и загрузка\n";
+                    std::cout << "Введите выбор: ";
+                    int benchChoice;
+                    std::cin >> benchChoice;
+                    switch (benchChoice) {
+                        case 1:
+                            benchmarkLogger();
+                            break;
+                        case 2:
+                            benchmarkLogRecords();
+                            break;
+                        case 3:
+                            benchmarkSimulation();
+                            break;
+                        case 4:
+                            benchmarkCombatCore();
+                            break;
+                        case 5:
+                            benchmarkMonsterCatalog();
+                            break;
+                        case 6:
+                            benchmarkInventory();
+                            break;
+                        case 7:
+                            benchmarkSaveGame();
+                            break;
+                        default:
+                            std::cout << "Неверный выбор." << std::endl;
+                            break;
+                    }
+                    break;
+                }
+                default: {
+                    std::cout << "Неверный выбор. Пожалуйста, попробуйте снова." << std::endl;
+                    break;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+    }
+    return 0;
+}